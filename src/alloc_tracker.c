@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "alloc_tracker.h"
+#include "profiler.h"
+
+#if ALLOC_TRACKING_ENABLED
+
+#include <new>
+
+#define ALLOC_OUTSIDE_STAGES PROFILE_STAGE_COUNT  // Allocations made while no profiled stage is open
+
+bool allocTrackingActive = false;  // Only changed while no other thread is running
+
+static int allocCheckAfterTick = -1;
+static SDL_atomic_t allocCounts[PROFILE_STAGE_COUNT + 1];
+static SDL_atomic_t allocTotal;
+static SDL_atomic_t allocFrees;
+static SDL_atomic_t allocTick;  // Ticks closed since tracking started
+static SDL_atomic_t allocLate;  // Allocations once the check applies
+static SDL_atomic_t allocLateRecorded;
+static int allocFirstLateStage;
+static size_t allocFirstLateSize;
+static int allocFirstLateTick;
+
+// Per tick totals, only touched by the simulation thread
+static int allocLastTotal = 0;
+static int allocTicksAllocating = 0;
+static int allocMostInTick = 0;
+
+// Threads are looked up by id, thread-local storage may allocate on first use
+// and would recurse into the hook. Slots are claimed in order and never freed.
+static void *allocThreads[ALLOC_MAX_THREADS];
+static int allocThreadStages[ALLOC_MAX_THREADS];  // Innermost stage open on each thread
+
+static int findAllocThread(void)
+{
+    void *self = (void *)(uintptr_t)SDL_ThreadID();
+    for (int i = 0; i < ALLOC_MAX_THREADS; i++)
+    {
+        void *thread = SDL_AtomicGetPtr(&allocThreads[i]);
+        if (thread == self)
+            return i;
+        if (thread == NULL && SDL_AtomicCASPtr(&allocThreads[i], NULL, self))
+        {
+            allocThreadStages[i] = ALLOC_OUTSIDE_STAGES;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static const char *allocStageName(int stage)
+{
+#if PROFILER_ENABLED
+    if (stage < ALLOC_OUTSIDE_STAGES)
+        return profileStageName((ProfileStage)stage);
+#endif
+    return "outside stages";
+}
+
+static void countAllocation(size_t size)
+{
+    if (!allocTrackingActive)
+        return;
+
+    int thread = findAllocThread();
+    int stage = thread >= 0 ? allocThreadStages[thread] : ALLOC_OUTSIDE_STAGES;
+    SDL_AtomicAdd(&allocCounts[stage], 1);
+    SDL_AtomicAdd(&allocTotal, 1);
+
+    if (allocCheckAfterTick >= 0 && SDL_AtomicGet(&allocTick) >= allocCheckAfterTick)
+    {
+        SDL_AtomicAdd(&allocLate, 1);
+        if (SDL_AtomicCAS(&allocLateRecorded, 0, 1))
+        {
+            allocFirstLateStage = stage;
+            allocFirstLateSize = size;
+            allocFirstLateTick = SDL_AtomicGet(&allocTick);
+        }
+    }
+}
+
+bool startAllocTracking(int checkAfterTick)
+{
+    for (int i = 0; i <= ALLOC_OUTSIDE_STAGES; i++)
+        SDL_AtomicSet(&allocCounts[i], 0);
+    SDL_AtomicSet(&allocTotal, 0);
+    SDL_AtomicSet(&allocFrees, 0);
+    SDL_AtomicSet(&allocTick, 0);
+    SDL_AtomicSet(&allocLate, 0);
+    SDL_AtomicSet(&allocLateRecorded, 0);
+    allocLastTotal = 0;
+    allocTicksAllocating = 0;
+    allocMostInTick = 0;
+    allocCheckAfterTick = checkAfterTick;
+    allocTrackingActive = true;
+    return true;
+}
+
+bool stopAllocTracking(void)
+{
+    if (!allocTrackingActive)
+        return true;
+
+    // Called once every other thread has finished
+    allocTrackingActive = false;
+
+    int ticks = SDL_AtomicGet(&allocTick);
+    printf("Allocations: %d (%d frees), %d of %d ticks allocated, at most %d in one tick\n",
+           SDL_AtomicGet(&allocTotal), SDL_AtomicGet(&allocFrees), allocTicksAllocating, ticks, allocMostInTick);
+    for (int i = 0; i <= ALLOC_OUTSIDE_STAGES; i++)
+    {
+        int count = SDL_AtomicGet(&allocCounts[i]);
+        if (count != 0)
+            printf("  %-20s %10d\n", allocStageName(i), count);
+    }
+
+    if (allocCheckAfterTick < 0)
+        return true;
+
+    int late = SDL_AtomicGet(&allocLate);
+    if (late == 0)
+    {
+        printf("Allocation check passed: none after tick %d\n", allocCheckAfterTick);
+        return true;
+    }
+    printf("Allocation check failed: %d after tick %d, the first of %llu bytes in %s at tick %d\n",
+           late, allocCheckAfterTick, (unsigned long long)allocFirstLateSize, allocStageName(allocFirstLateStage),
+           allocFirstLateTick);
+    return false;
+}
+
+int enterAllocStage(int stage)
+{
+    if (!allocTrackingActive)
+        return ALLOC_OUTSIDE_STAGES;
+
+    int thread = findAllocThread();
+    if (thread < 0)
+        return ALLOC_OUTSIDE_STAGES;
+    int previous = allocThreadStages[thread];
+    allocThreadStages[thread] = stage;
+    return previous;
+}
+
+void leaveAllocStage(int previous)
+{
+    if (!allocTrackingActive)
+        return;
+
+    int thread = findAllocThread();
+    if (thread >= 0)
+        allocThreadStages[thread] = previous;
+}
+
+void countAllocTick(void)
+{
+    // Includes whatever the other threads allocated while the tick ran
+    int total = SDL_AtomicGet(&allocTotal);
+    int allocated = total - allocLastTotal;
+    allocLastTotal = total;
+    if (allocated > 0)
+    {
+        allocTicksAllocating++;
+        if (allocated > allocMostInTick)
+            allocMostInTick = allocated;
+    }
+    SDL_AtomicAdd(&allocTick, 1);
+}
+
+// --wrap only redirects references from the program's own objects, so SDL and
+// the C runtime keep allocating unseen
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__real_calloc(size_t count, size_t size);
+extern "C" void *__real_realloc(void *block, size_t size);
+extern "C" void __real_free(void *block);
+
+extern "C" void *__wrap_malloc(size_t size)
+{
+    countAllocation(size);
+    return __real_malloc(size);
+}
+
+extern "C" void *__wrap_calloc(size_t count, size_t size)
+{
+    countAllocation(count * size);
+    return __real_calloc(count, size);
+}
+
+extern "C" void *__wrap_realloc(void *block, size_t size)
+{
+    // Growing may move the block, so it counts like a new allocation
+    if (size != 0)
+        countAllocation(size);
+    return __real_realloc(block, size);
+}
+
+extern "C" void __wrap_free(void *block)
+{
+    if (block != NULL && allocTrackingActive)
+        SDL_AtomicAdd(&allocFrees, 1);
+    __real_free(block);
+}
+
+// Replaced so new and delete go through the wrapped malloc and free
+void *operator new(size_t size)
+{
+    void *block = malloc(size != 0 ? size : 1);
+    if (block == NULL)
+        throw std::bad_alloc();
+    return block;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *block) noexcept
+{
+    free(block);
+}
+
+void operator delete[](void *block) noexcept
+{
+    free(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+    free(block);
+}
+
+void operator delete[](void *block, size_t) noexcept
+{
+    free(block);
+}
+
+#endif
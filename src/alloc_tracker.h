@@ -0,0 +1,47 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Allocation tracking interposes malloc, calloc, realloc and free with the
+// linker's --wrap option, and replaces operator new and delete, so it is only
+// built into `make alloc-check`. Build with -DALLOC_TRACKING_ENABLED=1 and
+// -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free to do the same by hand.
+#ifndef ALLOC_TRACKING_ENABLED
+#define ALLOC_TRACKING_ENABLED 0
+#endif
+
+#define ALLOC_MAX_THREADS 16
+
+#if ALLOC_TRACKING_ENABLED
+
+// Every allocation made by the program's own code is counted against the
+// innermost profiled stage open on the calling thread, and the simulation
+// thread closes each tick's count. After checkAfterTick ticks any allocation
+// fails the check; a negative value only reports. Stopping prints the report
+// and returns whether the check passed.
+bool startAllocTracking(int checkAfterTick);
+bool stopAllocTracking(void);
+int enterAllocStage(int stage);
+void leaveAllocStage(int previous);
+void countAllocTick(void);
+
+extern bool allocTrackingActive;
+
+#define ALLOC_BEGIN(stage) int stage##_alloc = enterAllocStage(stage)
+#define ALLOC_END(stage) do { leaveAllocStage(stage##_alloc); } while (0)
+#define ALLOC_COUNT_TICK() do { if (allocTrackingActive) countAllocTick(); } while (0)
+
+#else
+
+#define startAllocTracking(checkAfterTick) (fputs("Allocation tracking needs a build with it, see make alloc-check\n", stderr), (void)(checkAfterTick), false)
+#define stopAllocTracking() true
+#define ALLOC_BEGIN(stage)
+#define ALLOC_END(stage) ((void)0)
+#define ALLOC_COUNT_TICK() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,863 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "traffic_simulation.h"
+#include "scenario.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define BENCH_DEFAULT_INTERSECTIONS 10000
+#define BENCH_DEFAULT_TICKS (SIM_TICK_RATE * 60)
+#define BENCH_SEED 12345
+
+// Kernel microbenchmarks: every kernel runs a fixed amount of work per
+// repetition, so results from different builds are directly comparable
+#define BENCH_DEFAULT_REPETITIONS 50
+#define BENCH_DEFAULT_WARMUP 5
+#define BENCH_VEHICLE_PASSES 20          // updateVehicle calls per fleet vehicle per repetition
+#define BENCH_LANE_POSITION_CALLS 200
+#define BENCH_LANE_LOOKUPS 100000
+#define BENCH_INIT_CALLS 10000
+#define BENCH_QUEUE_DEPTH 16             // Entries kept in the queue while enqueue/dequeue pairs run
+#define BENCH_QUEUE_PAIRS 100000
+#define BENCH_SIGNAL_UPDATES 10000
+
+// Scaling runs keep the simulation full at MAX_VEHICLES, so each population is its own build
+#define BENCH_SCALING_TICKS (SIM_TICK_RATE * 10)
+#define BENCH_SCALING_BUDGET 60          // Seconds, checked between ticks and while probing the first one
+#define BENCH_SCALING_PROBE_STRIDE 1024  // Vehicles probed between budget checks
+#define BENCH_SCALING_SPREAD 200         // Pixels past the spawn point the initial vehicles are spread over
+
+// Synthetic demand, in chances per lane per tick
+#define BENCH_ARRIVAL_ODDS 240      // About one arrival every four seconds per lane at 60 ticks/s
+#define BENCH_DISCHARGE_ODDS 60     // A green lane discharges about one vehicle per second
+#define BENCH_EMERGENCY_ODDS 200000
+
+typedef struct {
+    SignalController controller;
+    SignalInput input;
+    int timer;        // Pending decision on the timing wheel
+    Uint32 dueTick;   // Last tick the intersection was queued for a step
+} BenchIntersection;
+
+// Timer pool and list of intersections to step, for the scheduled runs
+static Timer *benchTimers;
+static int *benchDue;
+
+static Uint32 benchRandomState;
+
+static Uint32 benchRandom(void)
+{
+    // xorshift32, so runs are identical on every platform
+    benchRandomState ^= benchRandomState << 13;
+    benchRandomState ^= benchRandomState >> 17;
+    benchRandomState ^= benchRandomState << 5;
+    return benchRandomState;
+}
+
+// Returns whether the intersection's detector readings changed
+static bool updateDemand(BenchIntersection *intersection, Uint32 time)
+{
+    SignalInput *input = &intersection->input;
+    input->time = time;
+    bool changed = false;
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        bool green = (lane < 2) == (intersection->controller.phase == SIGNAL_PHASE_NORTH_SOUTH);
+
+        if (benchRandom() % BENCH_ARRIVAL_ODDS == 0)
+        {
+            input->queueLengths[lane]++;
+            changed = true;
+        }
+        if (benchRandom() % BENCH_EMERGENCY_ODDS == 0)
+        {
+            input->emergencyVehicles[lane]++;
+            changed = true;
+        }
+
+        if (green && benchRandom() % BENCH_DISCHARGE_ODDS == 0)
+        {
+            if (input->emergencyVehicles[lane] > 0)
+            {
+                input->emergencyVehicles[lane]--;
+                changed = true;
+            }
+            else if (input->queueLengths[lane] > 0)
+            {
+                input->queueLengths[lane]--;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+static Uint32 benchTickAt(Uint32 milliseconds)
+{
+    return (Uint32)(((Uint64)milliseconds * SIM_TICK_RATE + 999) / 1000);
+}
+
+// Steps a controller and files its next timed decision, as stepSimulation() does
+static int stepScheduled(TimingWheel *wheel, BenchIntersection *intersection, int index, Uint32 tick)
+{
+    int events = stepSignalController(&intersection->controller, &intersection->input);
+
+    cancelTimer(wheel, intersection->timer);
+    intersection->timer = -1;
+    Uint32 decision = nextSignalDecision(&intersection->controller, &intersection->input);
+    if (decision != SIGNAL_WAIT_FOR_INPUT)
+    {
+        Uint32 decisionTick = decision > intersection->input.time ? benchTickAt(decision) : tick + 1;
+        intersection->timer = scheduleTimer(wheel, decisionTick, 0, index);
+    }
+    return events;
+}
+
+// Runs every intersection's controller against the same seeded demand,
+// timing only the controller work. Polled runs step every controller on every
+// tick; scheduled runs step only those whose input changed or whose timer
+// fired on the timing wheel.
+static void benchmarkController(SignalControllerType type, bool scheduled, BenchIntersection *intersections, int count, int ticks)
+{
+    benchRandomState = BENCH_SEED;
+    memset(intersections, 0, sizeof(*intersections) * count);
+    for (int i = 0; i < count; i++)
+    {
+        initSignalController(&intersections[i].controller, type);
+        intersections[i].timer = -1;
+    }
+
+    TimingWheel wheel;
+    initTimingWheel(&wheel, benchTimers, count, 0);
+
+    Uint64 elapsed = 0;
+    long long steps = 0;
+    long long phaseChanges = 0;
+    long long queued = 0;
+
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        Uint32 time = (Uint32)((Uint64)tick * 1000 / SIM_TICK_RATE);
+        int due = 0;
+        for (int i = 0; i < count; i++)
+        {
+            // Every controller steps on the first tick
+            if (updateDemand(&intersections[i], time) || tick == 0)
+            {
+                intersections[i].dueTick = tick;
+                benchDue[due++] = i;
+            }
+        }
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (scheduled)
+        {
+            advanceTimingWheel(&wheel, tick);
+            Timer fired;
+            while (popExpiredTimer(&wheel, &fired))
+            {
+                BenchIntersection *intersection = &intersections[fired.target];
+                intersection->timer = -1;
+                if (intersection->dueTick != (Uint32)tick)
+                {
+                    intersection->dueTick = tick;
+                    benchDue[due++] = fired.target;
+                }
+            }
+
+            for (int i = 0; i < due; i++)
+            {
+                if (stepScheduled(&wheel, &intersections[benchDue[i]], benchDue[i], tick) & SIGNAL_EVENT_PHASE_CHANGE)
+                    phaseChanges++;
+            }
+            steps += due;
+        }
+        else
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (stepSignalController(&intersections[i].controller, &intersections[i].input) & SIGNAL_EVENT_PHASE_CHANGE)
+                    phaseChanges++;
+            }
+            steps += count;
+        }
+        elapsed += SDL_GetPerformanceCounter() - start;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            queued += intersections[i].input.queueLengths[lane];
+        }
+    }
+
+    double nanoseconds = elapsed * 1e9 / SDL_GetPerformanceFrequency();
+    printf("%-14s %-10s %12.2f %10.3f %12.1f %14lld %12.2f\n",
+           signalControllerName(type), scheduled ? "scheduled" : "polled",
+           nanoseconds / ((double)count * ticks), nanoseconds / ticks / 1e6, (double)steps / ticks,
+           phaseChanges, (double)queued / count);
+}
+
+// Where a benchmarked vehicle starts: on the approach, stopped at the line, or inside the intersection
+typedef enum {
+    BENCH_STATE_APPROACHING,
+    BENCH_STATE_QUEUED,
+    BENCH_STATE_CROSSING,
+    BENCH_STATE_COUNT
+} BenchVehicleState;
+
+static const char *BENCH_DIRECTION_NAMES[4] = {"north", "south", "east", "west"};
+static const char *BENCH_TURN_NAMES[3] = {"straight", "left", "right"};
+static const char *BENCH_STATE_NAMES[BENCH_STATE_COUNT] = {"approaching", "queued", "crossing"};
+
+typedef struct {
+    const char *name;
+    int operations;       // Per repetition
+    double meanNanoseconds;  // Per operation, over the measured repetitions
+    double stddevNanoseconds;
+    double minNanoseconds;
+    double maxNanoseconds;
+} KernelResult;
+
+typedef struct {
+    int repetitions;
+    int warmup;
+    FILE *json;
+    int results;
+} KernelRun;
+
+typedef void (*KernelSetup)(void);
+typedef Uint64 (*KernelBody)(void);
+
+// Every vehicle combination, and the fleet a kernel runs on
+static Vehicle benchCombinations[4 * 3 * BENCH_STATE_COUNT];
+static Vehicle benchFleetTemplate[MAX_VEHICLES];
+static Vehicle benchFleet[MAX_VEHICLES];
+static TrafficLight benchLights[4];
+static Simulation benchSimulation;
+static Queue benchQueue;
+static QueueNodePool benchQueueNodes;
+static Uint32 benchVehicleRandom;  // Type and turn draws for the kernel vehicles
+
+// Results are folded into this so the compiler cannot drop the work
+static volatile Uint64 benchSink;
+
+static Vehicle makeBenchVehicle(Direction direction, TurnDirection turn, BenchVehicleState state)
+{
+    // initVehicle rolls the type and turn itself, keep drawing until the turn matches
+    Vehicle vehicle;
+    do
+    {
+        initVehicle(&vehicle, direction, &benchVehicleRandom);
+    } while (vehicle.turnDirection != turn);
+
+    if (state == BENCH_STATE_QUEUED)
+    {
+        // 20 pixels short of the stop line, inside the distance where a red light holds it
+        switch (direction)
+        {
+        case DIRECTION_NORTH:
+            vehicle.y = INTERSECTION_Y + LANE_WIDTH + 20;
+            break;
+        case DIRECTION_SOUTH:
+            vehicle.y = INTERSECTION_Y - LANE_WIDTH - 20;
+            break;
+        case DIRECTION_EAST:
+            vehicle.x = INTERSECTION_X - LANE_WIDTH - 20;
+            break;
+        case DIRECTION_WEST:
+            vehicle.x = INTERSECTION_X + LANE_WIDTH + 20;
+            break;
+        }
+        vehicle.state = STATE_STOPPED;
+        vehicle.speed = 0;
+    }
+    else if (state == BENCH_STATE_CROSSING)
+    {
+        // At the turn point, a third of the way through a turn when there is one
+        if (direction == DIRECTION_NORTH || direction == DIRECTION_SOUTH)
+            vehicle.y = INTERSECTION_Y;
+        else
+            vehicle.x = INTERSECTION_X;
+        if (turn != TURN_NONE)
+        {
+            vehicle.state = STATE_TURNING;
+            vehicle.turnAngle = 30.0f;
+        }
+    }
+
+    vehicle.rect.x = (int)vehicle.x;
+    vehicle.rect.y = (int)vehicle.y;
+    vehicle.prevX = vehicle.x;
+    vehicle.prevY = vehicle.y;
+    return vehicle;
+}
+
+static void initKernelFixtures(void)
+{
+    benchVehicleRandom = BENCH_SEED;
+    initQueue(&benchQueue, &benchQueueNodes);
+    int count = 0;
+    for (int direction = 0; direction < 4; direction++)
+    {
+        for (int turn = 0; turn < 3; turn++)
+        {
+            for (int state = 0; state < BENCH_STATE_COUNT; state++)
+            {
+                benchCombinations[count++] = makeBenchVehicle((Direction)direction, (TurnDirection)turn, (BenchVehicleState)state);
+            }
+        }
+    }
+
+    // Every light red, so queued vehicles that may not skip it stay queued
+    initializeTrafficLights(benchLights);
+    for (int i = 0; i < 4; i++)
+    {
+        benchLights[i].state = RED;
+    }
+}
+
+// Fills the fleet template with the matching combinations, repeated up to MAX_VEHICLES.
+// -1 matches any direction, turn or state.
+static void selectBenchFleet(int direction, int turn, int state)
+{
+    int matches = 0;
+    int total = (int)(sizeof(benchCombinations) / sizeof(benchCombinations[0]));
+    for (int i = 0; i < total; i++)
+    {
+        int combinationState = i % BENCH_STATE_COUNT;
+        int combinationTurn = i / BENCH_STATE_COUNT % 3;
+        int combinationDirection = i / (BENCH_STATE_COUNT * 3);
+        if ((direction < 0 || direction == combinationDirection) && (turn < 0 || turn == combinationTurn) &&
+            (state < 0 || state == combinationState))
+        {
+            benchFleetTemplate[matches++] = benchCombinations[i];
+        }
+    }
+    for (int i = matches; i < MAX_VEHICLES; i++)
+    {
+        benchFleetTemplate[i] = benchFleetTemplate[i % matches];
+    }
+}
+
+static void resetBenchFleet(void)
+{
+    memcpy(benchFleet, benchFleetTemplate, sizeof(benchFleet));
+    updateLanePositions(&benchSimulation.lanes, benchFleet);
+}
+
+static Uint64 benchUpdateVehicle(void)
+{
+    for (int pass = 0; pass < BENCH_VEHICLE_PASSES; pass++)
+    {
+        for (int i = 0; i < MAX_VEHICLES; i++)
+        {
+            updateVehicle(&benchFleet[i], benchLights, &benchSimulation.lanes);
+        }
+    }
+    return (Uint64)benchFleet[MAX_VEHICLES - 1].x;
+}
+
+static Uint64 benchUpdateLanePositions(void)
+{
+    for (int i = 0; i < BENCH_LANE_POSITION_CALLS; i++)
+    {
+        updateLanePositions(&benchSimulation.lanes, benchFleet);
+    }
+    return (Uint64)benchFleet[0].y;
+}
+
+static Uint64 benchGetVehicleLane(void)
+{
+    Uint64 sum = 0;
+    for (int i = 0; i < BENCH_LANE_LOOKUPS; i++)
+    {
+        sum += getVehicleLane(&benchFleet[i % MAX_VEHICLES]);
+    }
+    return sum;
+}
+
+static void resetInitVehicle(void)
+{
+    benchVehicleRandom = BENCH_SEED;
+}
+
+static Uint64 benchInitVehicle(void)
+{
+    Uint64 sum = 0;
+    Vehicle vehicle;
+    for (int i = 0; i < BENCH_INIT_CALLS; i++)
+    {
+        initVehicle(&vehicle, (Direction)(i & 3), &benchVehicleRandom);
+        sum += vehicle.type;
+    }
+    return sum;
+}
+
+static void resetBenchQueue(void)
+{
+    clearQueue(&benchQueue);
+    for (int i = 0; i < BENCH_QUEUE_DEPTH; i++)
+    {
+        QueueEntry entry = {i, 0};
+        enqueue(&benchQueue, entry);
+    }
+}
+
+static Uint64 benchEnqueueDequeue(void)
+{
+    Uint64 sum = 0;
+    for (int i = 0; i < BENCH_QUEUE_PAIRS; i++)
+    {
+        QueueEntry entry = {i, (Uint32)i};
+        enqueue(&benchQueue, entry);
+        sum += dequeue(&benchQueue).vehicle;
+    }
+    return sum;
+}
+
+static void resetBenchSimulation(void)
+{
+    initSimulation(&benchSimulation);
+
+    // Uneven queues, so congestion priority and the demand-driven controllers have work to do
+    static const int BENCH_QUEUE_LENGTHS[4] = {3, 7, 1, 0};
+    for (int lane = 0; lane < 4; lane++)
+    {
+        for (int i = 0; i < BENCH_QUEUE_LENGTHS[lane]; i++)
+        {
+            QueueEntry entry = {i, 0};
+            enqueue(&benchSimulation.laneQueues[lane], entry);
+        }
+    }
+}
+
+static Uint64 benchUpdateTrafficLights(void)
+{
+    // One controller decision per simulated tick
+    for (int i = 0; i < BENCH_SIGNAL_UPDATES; i++)
+    {
+        benchSimulation.tick++;
+        benchSimulation.time = (Uint32)((Uint64)benchSimulation.tick * 1000 / simulationTickRate);
+        updateTrafficLights(&benchSimulation);
+    }
+    return (Uint64)benchSimulation.controller.phase;
+}
+
+// Runs the setup untimed before every repetition, discards the warmup
+// repetitions and reports ns per operation over the rest
+static void runKernel(KernelRun *run, const char *name, int operations, KernelSetup setup, KernelBody body)
+{
+    KernelResult result;
+    result.name = name;
+    result.operations = operations;
+    result.minNanoseconds = 0;
+    result.maxNanoseconds = 0;
+
+    double nanosecondsPerTick = 1e9 / (double)SDL_GetPerformanceFrequency();
+    double sum = 0;
+    double sumSquares = 0;
+    for (int repetition = -run->warmup; repetition < run->repetitions; repetition++)
+    {
+        if (setup != NULL)
+            setup();
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        benchSink += body();
+        double nanoseconds = (SDL_GetPerformanceCounter() - start) * nanosecondsPerTick / operations;
+        if (repetition < 0)
+            continue;
+
+        sum += nanoseconds;
+        sumSquares += nanoseconds * nanoseconds;
+        if (repetition == 0 || nanoseconds < result.minNanoseconds)
+            result.minNanoseconds = nanoseconds;
+        if (nanoseconds > result.maxNanoseconds)
+            result.maxNanoseconds = nanoseconds;
+    }
+
+    result.meanNanoseconds = sum / run->repetitions;
+    double variance = sumSquares / run->repetitions - result.meanNanoseconds * result.meanNanoseconds;
+    result.stddevNanoseconds = variance > 0 ? sqrt(variance) : 0;
+
+    printf("%-44s %10d %10.2f %10.2f %10.2f %10.2f\n", result.name, result.operations, result.meanNanoseconds,
+           result.stddevNanoseconds, result.minNanoseconds, result.maxNanoseconds);
+    if (run->json != NULL)
+    {
+        fprintf(run->json, "%s\n    {\"name\": \"%s\", \"operations\": %d, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f}",
+                run->results > 0 ? "," : "", result.name, result.operations, result.meanNanoseconds,
+                result.stddevNanoseconds, result.minNanoseconds, result.maxNanoseconds);
+    }
+    run->results++;
+}
+
+// updateVehicle for every direction, turn and starting state on its own, then all mixed
+static void benchmarkUpdateVehicle(KernelRun *run)
+{
+    char name[64];
+    for (int direction = -1; direction < 4; direction++)
+    {
+        for (int turn = -1; turn < 3; turn++)
+        {
+            for (int state = -1; state < BENCH_STATE_COUNT; state++)
+            {
+                // Vary one axis at a time, or none for the mixed fleet
+                int fixed = (direction >= 0) + (turn >= 0) + (state >= 0);
+                if (fixed > 1)
+                    continue;
+
+                const char *axis = direction >= 0 ? "direction" : turn >= 0 ? "turn" : state >= 0 ? "state" : "mix";
+                const char *value = direction >= 0 ? BENCH_DIRECTION_NAMES[direction] : turn >= 0 ? BENCH_TURN_NAMES[turn]
+                                                     : state >= 0                                   ? BENCH_STATE_NAMES[state]
+                                                                                                     : "all";
+                snprintf(name, sizeof(name), "updateVehicle/%s=%s", axis, value);
+                selectBenchFleet(direction, turn, state);
+                runKernel(run, name, MAX_VEHICLES * BENCH_VEHICLE_PASSES, resetBenchFleet, benchUpdateVehicle);
+            }
+        }
+    }
+}
+
+static bool benchmarkKernels(int repetitions, int warmup, const char *jsonPath)
+{
+    KernelRun run;
+    run.repetitions = repetitions;
+    run.warmup = warmup;
+    run.results = 0;
+    run.json = NULL;
+    if (jsonPath != NULL)
+    {
+        run.json = fopen(jsonPath, "w");
+        if (run.json == NULL)
+        {
+            perror("Failed to open JSON output");
+            return false;
+        }
+        fprintf(run.json, "{\n  \"suite\": \"kernels\",\n  \"max_vehicles\": %d,\n  \"tick_rate\": %d,\n  \"repetitions\": %d,\n  \"warmup\": %d,\n  \"results\": [",
+                MAX_VEHICLES, simulationTickRate, repetitions, warmup);
+    }
+
+    initKernelFixtures();
+
+    printf("Kernels: %d repetitions after %d warmup, %d vehicles\n", repetitions, warmup, MAX_VEHICLES);
+    printf("%-44s %10s %10s %10s %10s %10s\n", "kernel (ns/op)", "ops/rep", "mean", "stddev", "min", "max");
+    benchmarkUpdateVehicle(&run);
+
+    selectBenchFleet(-1, -1, -1);
+    resetBenchFleet();
+    runKernel(&run, "updateLanePositions", BENCH_LANE_POSITION_CALLS, NULL, benchUpdateLanePositions);
+    runKernel(&run, "getVehicleLane", BENCH_LANE_LOOKUPS, NULL, benchGetVehicleLane);
+    runKernel(&run, "initVehicle", BENCH_INIT_CALLS, resetInitVehicle, benchInitVehicle);
+    runKernel(&run, "enqueue+dequeue", BENCH_QUEUE_PAIRS, resetBenchQueue, benchEnqueueDequeue);
+    for (int type = 0; type < SIGNAL_CONTROLLER_TYPE_COUNT; type++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "updateTrafficLights/controller=%s", signalControllerName((SignalControllerType)type));
+        simulationControllerType = (SignalControllerType)type;
+        runKernel(&run, name, BENCH_SIGNAL_UPDATES, resetBenchSimulation, benchUpdateTrafficLights);
+    }
+    simulationControllerType = SIGNAL_CONTROLLER_PRIORITY;
+    clearQueue(&benchQueue);
+
+    if (run.json != NULL)
+    {
+        fprintf(run.json, "\n  ]\n}\n");
+        fclose(run.json);
+        printf("Wrote %d results to %s\n", run.results, jsonPath);
+    }
+    return true;
+}
+
+static long peakResidentKilobytes(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;  // Kilobytes on Linux
+#endif
+}
+
+// Puts a new vehicle in every free slot. Used untimed between ticks, so the
+// population stays at MAX_VEHICLES while vehicles leave the screen.
+static void fillSimulation(Simulation *sim, bool spread)
+{
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        if (sim->vehicles[i].active)
+            continue;
+
+        Direction direction = (Direction)(rand() % 4);
+        Vehicle *vehicle = &sim->vehicles[i];
+        initVehicle(vehicle, direction, &sim->random);
+
+        // The initial population is spread along the approaches, refills enter at the edge
+        if (spread)
+        {
+            float distance = (float)(rand() % BENCH_SCALING_SPREAD);
+            if (direction == DIRECTION_NORTH)
+                vehicle->y -= distance;
+            else if (direction == DIRECTION_SOUTH)
+                vehicle->y += distance;
+            else if (direction == DIRECTION_EAST)
+                vehicle->x += distance;
+            else
+                vehicle->x -= distance;
+            vehicle->prevX = vehicle->x;
+            vehicle->prevY = vehicle->y;
+        }
+
+        trackVehicleLane(sim, vehicle);
+        sim->vehicleCount++;
+        sim->stats.totalVehicles++;
+    }
+    sim->signalDue = true;
+}
+
+// Times the vehicle pass of one tick on copies of the vehicles, checking the
+// budget every BENCH_SCALING_PROBE_STRIDE vehicles, so a population whose
+// tick cannot fit is found without running that tick. Returns the projected
+// tick time in counter ticks, or 0 when the pass fits the budget.
+static Uint64 probeScalingTick(Simulation *sim, Uint64 budget)
+{
+    Uint64 started = SDL_GetPerformanceCounter();
+    updateLanePositions(&sim->lanes, sim->vehicles);
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        Vehicle vehicle = sim->vehicles[i];
+        if (vehicle.active)
+            updateVehicle(&vehicle, sim->lights, &sim->lanes);
+        benchSink += (Uint64)vehicle.x;
+
+        if ((i + 1) % BENCH_SCALING_PROBE_STRIDE == 0)
+        {
+            Uint64 elapsed = SDL_GetPerformanceCounter() - started;
+            if (elapsed >= budget)
+                return (Uint64)((double)elapsed * MAX_VEHICLES / (i + 1));
+        }
+    }
+    return 0;
+}
+
+// Runs the full headless tick with the simulation kept at MAX_VEHICLES over
+// a fixed seed and horizon, and breaks the cost down by profiled stage. A
+// scenario replaces the seed and the vehicle mix.
+static void benchmarkScaling(int ticks, int budgetSeconds, const Scenario *scenario)
+{
+    if (scenario != NULL)
+        applyScenario(scenario);
+    else
+        srand(BENCH_SEED);
+    initSimulation(&benchSimulation);
+    fillSimulation(&benchSimulation, true);
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 budget = (Uint64)budgetSeconds * frequency;
+
+    // The budget is otherwise only checked between ticks, a single tick of a
+    // large population could run far past it
+    Uint64 projected = probeScalingTick(&benchSimulation, budget);
+    if (projected != 0)
+    {
+        printf("Scaling: %d vehicles, over budget: one tick projected at %.1f s against a %d s budget%s%s\n",
+               MAX_VEHICLES, (double)projected / frequency, budgetSeconds, scenario != NULL ? ", scenario " : "",
+               scenario != NULL ? scenario->name : "");
+        printf("Peak RSS: %ld KB\n", peakResidentKilobytes());
+        return;
+    }
+
+    Uint64 started = SDL_GetPerformanceCounter();
+    Uint64 elapsed = 0;
+    int ticksRun = 0;
+    while (ticksRun < ticks && (ticksRun == 0 || SDL_GetPerformanceCounter() - started < budget))
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        stepSimulation(&benchSimulation);
+        elapsed += SDL_GetPerformanceCounter() - start;
+        ticksRun++;
+        fillSimulation(&benchSimulation, false);
+    }
+
+    double vehicleTicks = (double)MAX_VEHICLES * ticksRun;
+    double nanoseconds = elapsed * 1e9 / frequency;
+    printf("Scaling: %d vehicles, %d of %d ticks%s%s%s\n", MAX_VEHICLES, ticksRun, ticks,
+           ticksRun < ticks ? " (stopped at the time budget)" : "", scenario != NULL ? ", scenario " : "",
+           scenario != NULL ? scenario->name : "");
+    printf("%-20s %14s %14s %8s\n", "stage", "ms/tick", "ns/vehicle", "share");
+    printf("%-20s %14.3f %14.2f %7.1f%%\n", "stepSimulation", nanoseconds / ticksRun / 1e6, nanoseconds / vehicleTicks, 100.0);
+
+#if PROFILER_ENABLED
+    // Stages other than the tick itself are summed over the ticks they ran in
+    for (int i = PROFILE_LANE_POSITIONS; i < PROFILE_SIMULATION_STAGES; i++)
+    {
+        ProfileSummary summary;
+        summarizeProfile((ProfileStage)i, &summary);
+        double stageNanoseconds = summary.meanMicroseconds * 1e3 * summary.count;
+        printf("%-20s %14.3f %14.2f %7.1f%%\n", profileStageName((ProfileStage)i), stageNanoseconds / ticksRun / 1e6,
+               stageNanoseconds / vehicleTicks, nanoseconds > 0 ? 100.0 * stageNanoseconds / nanoseconds : 0.0);
+    }
+#endif
+
+    printf("Peak RSS: %ld KB, %lld vehicles passed\n", peakResidentKilobytes(), (long long)benchSimulation.stats.vehiclesPassed);
+}
+
+// Runs a named scenario's full horizon through the headless tick, without rendering
+static void benchmarkScenario(const Scenario *scenario)
+{
+    applyScenario(scenario);
+    initSimulation(&benchSimulation);
+
+    int ticks = scenarioTicks(scenario);
+    Uint64 elapsed = 0;
+    Uint64 slowest = 0;
+    long long vehicleTicks = 0;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        stepSimulation(&benchSimulation);
+        Uint64 duration = SDL_GetPerformanceCounter() - start;
+        elapsed += duration;
+        if (duration > slowest)
+            slowest = duration;
+        vehicleTicks += benchSimulation.vehicleCount;
+    }
+
+    const Statistics *stats = &benchSimulation.stats;
+    double microsecondsPerTick = 1e6 / (double)SDL_GetPerformanceFrequency();
+    printf("%-16s %10d %10.3f %10.2f %10.2f %10.1f %10d %10.2f\n", scenario->name, ticks,
+           elapsed * microsecondsPerTick / 1e3, elapsed * microsecondsPerTick / ticks, slowest * microsecondsPerTick,
+           (double)vehicleTicks / ticks, stats->vehiclesPassed,
+           stats->vehiclesDischarged > 0 ? stats->totalWaitTime / 1000.0 / stats->vehiclesDischarged : 0.0);
+}
+
+static void benchmarkScenarios(const Scenario *only)
+{
+    printf("Scenarios: %s controller, %d ticks/s\n", signalControllerName(simulationControllerType), simulationTickRate);
+    printf("%-16s %10s %10s %10s %10s %10s %10s %10s\n", "scenario", "ticks", "total ms", "us/tick", "max us", "vehicles", "passed", "wait s");
+    for (int i = 0; i < scenarioCount(); i++)
+    {
+        if (only == NULL || only == getScenario(i))
+            benchmarkScenario(getScenario(i));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int intersections = BENCH_DEFAULT_INTERSECTIONS;
+    int ticks = BENCH_DEFAULT_TICKS;
+    int repetitions = BENCH_DEFAULT_REPETITIONS;
+    int warmup = BENCH_DEFAULT_WARMUP;
+    const char *jsonPath = NULL;
+    const char *suite = NULL;
+    int budget = BENCH_SCALING_BUDGET;
+    const Scenario *scenario = NULL;
+    bool ticksGiven = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--intersections") == 0 && i + 1 < argc)
+            intersections = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+        {
+            ticks = atoi(argv[++i]);
+            ticksGiven = true;
+        }
+        else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+            budget = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+            repetitions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--suite") == 0 && i + 1 < argc)
+            suite = argv[++i];
+        else if (strcmp(argv[i], "--controller") == 0 && i + 1 < argc)
+        {
+            if (!findSignalController(argv[++i], &simulationControllerType))
+            {
+                fprintf(stderr, "Unknown signal controller: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc)
+        {
+            scenario = findScenario(argv[++i]);
+            if (scenario == NULL)
+            {
+                fprintf(stderr, "Unknown scenario: %s. Scenarios:\n", argv[i]);
+                printScenarios(stderr);
+                return 1;
+            }
+        }
+    }
+    if (intersections <= 0 || ticks <= 0 || repetitions <= 0 || warmup < 0 || budget <= 0)
+    {
+        fprintf(stderr, "Intersection, tick and repetition counts and the budget must be positive\n");
+        return 1;
+    }
+
+    // Only run when asked for, the population is fixed by the build
+    if (suite != NULL && strcmp(suite, "scaling") == 0)
+    {
+        benchmarkScaling(ticksGiven ? ticks : BENCH_SCALING_TICKS, budget, scenario);
+        return 0;
+    }
+    if ((suite != NULL && strcmp(suite, "scenarios") == 0) || (suite == NULL && scenario != NULL))
+    {
+        benchmarkScenarios(scenario);
+        return 0;
+    }
+
+    // Both suites run unless one is named
+    bool runKernels = suite == NULL || strcmp(suite, "kernels") == 0;
+    bool runControllers = suite == NULL || strcmp(suite, "controllers") == 0;
+    if (!runKernels && !runControllers)
+    {
+        fprintf(stderr, "Unknown benchmark suite: %s\n", suite);
+        return 1;
+    }
+
+    if (runKernels && !benchmarkKernels(repetitions, warmup, jsonPath))
+        return 1;
+    if (!runControllers)
+        return 0;
+    if (runKernels)
+        printf("\n");
+
+    BenchIntersection *network = (BenchIntersection *)malloc(sizeof(BenchIntersection) * intersections);
+    benchTimers = (Timer *)malloc(sizeof(Timer) * intersections);
+    benchDue = (int *)malloc(sizeof(int) * intersections);
+    if (network == NULL || benchTimers == NULL || benchDue == NULL)
+    {
+        fprintf(stderr, "Failed to allocate %d intersections\n", intersections);
+        return 1;
+    }
+
+    printf("Signal controllers: %d intersections, %d ticks\n", intersections, ticks);
+    printf("%-14s %-10s %12s %10s %12s %14s %12s\n", "controller", "timers", "ns/int/tick", "ms/tick", "steps/tick", "phase changes", "final queue");
+    for (int type = 0; type < SIGNAL_CONTROLLER_TYPE_COUNT; type++)
+    {
+        benchmarkController((SignalControllerType)type, false, network, intersections, ticks);
+        benchmarkController((SignalControllerType)type, true, network, intersections, ticks);
+    }
+
+    free(benchDue);
+    free(benchTimers);
+    free(network);
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "event_log.h"
+#include "profiler.h"
+
+#if EVENT_LOG_ENABLED
+
+typedef struct {
+    EventRecord records[EVENT_LOG_RING_SIZE];
+    SDL_atomic_t head;   // Records logged, advanced by the owning thread only
+    SDL_atomic_t tail;   // Records written, advanced by the writer only
+    Uint32 dropped;      // Owned by the logging thread
+    int index;
+} EventRing;
+
+static FILE *eventLogFile = NULL;
+static char eventLogPath[260];
+static SDL_Thread *eventLogWriter = NULL;
+static SDL_atomic_t eventLogRunning;
+static SDL_TLSID eventLogRingKey = 0;
+static SDL_atomic_t eventLogRingCount;
+static void *eventLogRings[EVENT_LOG_MAX_THREADS];
+static SDL_atomic_t eventLogUnregistered;  // Records lost because every ring was taken
+static Uint32 eventLogWritten = 0;
+static bool eventLogActive = false;  // Only changed while no other thread is logging
+
+static EventRing *registerEventRing(void)
+{
+    int index = SDL_AtomicAdd(&eventLogRingCount, 1);
+    if (index >= EVENT_LOG_MAX_THREADS)
+        return NULL;
+
+    // Allocated once per logging thread, and kept until the log stops
+    EventRing *ring = (EventRing *)calloc(1, sizeof(EventRing));
+    if (ring == NULL)
+        return NULL;
+    ring->index = index;
+    SDL_TLSSet(eventLogRingKey, ring, NULL);
+    SDL_AtomicSetPtr(&eventLogRings[index], ring);
+    return ring;
+}
+
+static int eventRingCount(void)
+{
+    int count = SDL_AtomicGet(&eventLogRingCount);
+    return count < EVENT_LOG_MAX_THREADS ? count : EVENT_LOG_MAX_THREADS;
+}
+
+static bool eventRingsPending(void)
+{
+    int count = eventRingCount();
+    for (int i = 0; i < count; i++)
+    {
+        EventRing *ring = (EventRing *)SDL_AtomicGetPtr(&eventLogRings[i]);
+        if (ring != NULL && SDL_AtomicGet(&ring->head) != SDL_AtomicGet(&ring->tail))
+            return true;
+    }
+    return false;
+}
+
+static void drainEventRings(void)
+{
+    // Idle passes would bury the writes in the profile and the trace, so only
+    // passes with records to write are timed
+    if (!eventRingsPending())
+        return;
+
+    PROFILE_BEGIN(PROFILE_EVENT_LOG_WRITE);
+    int count = eventRingCount();
+    for (int i = 0; i < count; i++)
+    {
+        EventRing *ring = (EventRing *)SDL_AtomicGetPtr(&eventLogRings[i]);
+        if (ring == NULL)
+            continue;
+
+        Uint32 tail = (Uint32)SDL_AtomicGet(&ring->tail);
+        Uint32 head = (Uint32)SDL_AtomicGet(&ring->head);
+        SDL_MemoryBarrierAcquire();
+        if (head == tail)
+            continue;
+
+        // Write the pending span, in two pieces when it wraps around the ring
+        Uint32 start = tail & (EVENT_LOG_RING_SIZE - 1);
+        Uint32 pending = head - tail;
+        Uint32 first = pending < EVENT_LOG_RING_SIZE - start ? pending : EVENT_LOG_RING_SIZE - start;
+        fwrite(&ring->records[start], sizeof(EventRecord), first, eventLogFile);
+        fwrite(&ring->records[0], sizeof(EventRecord), pending - first, eventLogFile);
+        eventLogWritten += pending;
+
+        // Hand the slots back only after they have been copied out
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&ring->tail, (int)head);
+    }
+
+    PROFILE_END(PROFILE_EVENT_LOG_WRITE);
+}
+
+static int eventLogWriterThread(void *data)
+{
+    (void)data;
+    while (SDL_AtomicGet(&eventLogRunning))
+    {
+        drainEventRings();
+        SDL_Delay(EVENT_LOG_FLUSH_INTERVAL);
+    }
+    drainEventRings();
+    return 0;
+}
+
+bool startEventLog(const char *path)
+{
+    eventLogFile = fopen(path, "wb");
+    if (eventLogFile == NULL)
+    {
+        perror("Failed to open event log");
+        return false;
+    }
+    SDL_strlcpy(eventLogPath, path, sizeof(eventLogPath));
+
+    EventLogHeader header;
+    memcpy(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic));
+    header.version = EVENT_LOG_VERSION;
+    header.recordSize = sizeof(EventRecord);
+    fwrite(&header, sizeof(header), 1, eventLogFile);
+
+    // A fresh key per run, so no thread keeps a ring freed by an earlier stop
+    eventLogRingKey = SDL_TLSCreate();
+    if (eventLogRingKey == 0)
+    {
+        fprintf(stderr, "Failed to start event log: %s\n", SDL_GetError());
+        fclose(eventLogFile);
+        eventLogFile = NULL;
+        return false;
+    }
+    SDL_AtomicSet(&eventLogRingCount, 0);
+    SDL_AtomicSet(&eventLogUnregistered, 0);
+    SDL_AtomicSet(&eventLogRunning, 1);
+    eventLogWritten = 0;
+
+    // Set while this is the only thread, creating the writer publishes it
+    eventLogActive = true;
+    eventLogWriter = SDL_CreateThread(eventLogWriterThread, "event log", NULL);
+    if (eventLogWriter == NULL)
+    {
+        fprintf(stderr, "Failed to start event log: %s\n", SDL_GetError());
+        eventLogActive = false;
+        fclose(eventLogFile);
+        eventLogFile = NULL;
+        return false;
+    }
+    return true;
+}
+
+void stopEventLog(void)
+{
+    if (!eventLogActive)
+        return;
+
+    // Called once the logging threads have finished, the writer drains what is left
+    eventLogActive = false;
+    SDL_AtomicSet(&eventLogRunning, 0);
+    SDL_WaitThread(eventLogWriter, NULL);
+    eventLogWriter = NULL;
+    fclose(eventLogFile);
+    eventLogFile = NULL;
+
+    Uint32 dropped = (Uint32)SDL_AtomicGet(&eventLogUnregistered);
+    int count = SDL_AtomicGet(&eventLogRingCount);
+    for (int i = 0; i < count && i < EVENT_LOG_MAX_THREADS; i++)
+    {
+        EventRing *ring = (EventRing *)SDL_AtomicGetPtr(&eventLogRings[i]);
+        if (ring != NULL)
+            dropped += ring->dropped;
+        free(ring);
+        SDL_AtomicSetPtr(&eventLogRings[i], NULL);
+    }
+
+    printf("Event log %s: %u records written, %u dropped\n", eventLogPath, eventLogWritten, dropped);
+}
+
+void registerEventLogThread(void)
+{
+    if (eventLogActive && SDL_TLSGet(eventLogRingKey) == NULL && registerEventRing() == NULL)
+        fprintf(stderr, "No event log ring for this thread, its events will be dropped\n");
+}
+
+void logEvent(EventType type, Uint32 tick, Uint32 time, int intersection, int lane, EventReason reason, int phase, int controller)
+{
+    if (!eventLogActive)
+        return;
+
+    EventRing *ring = (EventRing *)SDL_TLSGet(eventLogRingKey);
+    if (ring == NULL && (ring = registerEventRing()) == NULL)
+    {
+        SDL_AtomicAdd(&eventLogUnregistered, 1);
+        return;
+    }
+
+    Uint32 head = (Uint32)SDL_AtomicGet(&ring->head);
+    if (head - (Uint32)SDL_AtomicGet(&ring->tail) >= EVENT_LOG_RING_SIZE)
+    {
+        ring->dropped++;
+        return;
+    }
+    SDL_MemoryBarrierAcquire();
+
+    EventRecord *record = &ring->records[head & (EVENT_LOG_RING_SIZE - 1)];
+    record->tick = tick;
+    record->time = time;
+    record->intersection = (Uint16)intersection;
+    record->type = (Uint8)type;
+    record->lane = (Sint8)lane;
+    record->reason = (Uint8)reason;
+    record->phase = (Uint8)phase;
+    record->controller = (Uint8)controller;
+    record->thread = (Uint8)ring->index;
+
+    // Publish the record only after its contents are visible to the writer
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->head, (int)(head + 1));
+}
+
+#endif
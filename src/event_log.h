@@ -0,0 +1,75 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// Build with -DEVENT_LOG_ENABLED=0 to compile every logging call out
+#ifndef EVENT_LOG_ENABLED
+#define EVENT_LOG_ENABLED 1
+#endif
+
+#define EVENT_LOG_MAGIC "TLOG"
+#define EVENT_LOG_VERSION 1
+#define EVENT_LOG_DEFAULT_PATH "events.bin"  // What the decoder reads when given no path
+#define EVENT_LOG_RING_SIZE 4096    // Records per thread, must be a power of two
+#define EVENT_LOG_MAX_THREADS 16
+#define EVENT_LOG_FLUSH_INTERVAL 10 // Milliseconds between writer passes
+
+typedef enum {
+    EVENT_PHASE_CHANGE,
+    EVENT_PRIORITY_START,
+    EVENT_PRIORITY_END
+} EventType;
+
+typedef enum {
+    EVENT_REASON_CYCLE,       // Decided by the controller's own timing or demand rule
+    EVENT_REASON_EMERGENCY,
+    EVENT_REASON_CONGESTION,
+    EVENT_REASON_CLEARED      // Priority lane no longer needs the green
+} EventReason;
+
+// One 16-byte record, written to the file as is after an EventLogHeader
+typedef struct {
+    Uint32 tick;
+    Uint32 time;           // Simulated milliseconds
+    Uint16 intersection;
+    Uint8 type;            // EventType
+    Sint8 lane;            // -1 when the event is not about a lane
+    Uint8 reason;          // EventReason
+    Uint8 phase;           // SIGNAL_PHASE_* shown after the event
+    Uint8 controller;      // SignalControllerType
+    Uint8 thread;          // Ring the record was logged through
+} EventRecord;
+
+typedef struct {
+    char magic[4];
+    Uint32 version;
+    Uint32 recordSize;
+} EventLogHeader;
+
+#if EVENT_LOG_ENABLED
+
+// Each logging thread appends compact binary records to its own lock-free
+// single-producer ring; a background writer drains the rings to disk. The
+// logging thread never formats, locks or waits, and records that find the
+// ring full are dropped and counted.
+bool startEventLog(const char* path);
+void stopEventLog(void);
+// Gives the calling thread its ring now, otherwise its first logged event
+// allocates one. Threads that log from timed work call it before starting.
+void registerEventLogThread(void);
+void logEvent(EventType type, Uint32 tick, Uint32 time, int intersection, int lane, EventReason reason, int phase, int controller);
+
+#define LOG_EVENT(...) logEvent(__VA_ARGS__)
+
+#else
+
+#define startEventLog(path) ((void)(path), true)
+#define stopEventLog() ((void)0)
+#define registerEventLogThread() ((void)0)
+#define LOG_EVENT(...) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <string.h>
+#include "event_log.h"
+#include "signal_controller.h"
+
+// Turns a binary event log written by the simulation back into text
+static void printEvent(const EventRecord *record)
+{
+    printf("[tick %u, intersection %u] ", record->tick, record->intersection);
+
+    switch (record->type)
+    {
+    case EVENT_PRIORITY_START:
+        printf("Priority mode activated at %u ms. Lane %d prioritized. Reason: %s\n",
+               record->time, record->lane, record->reason == EVENT_REASON_EMERGENCY ? "Emergency Vehicle" : "Congestion");
+        break;
+    case EVENT_PRIORITY_END:
+        printf("Priority mode deactivated at %u ms. Returning to normal cycle.\n", record->time);
+        break;
+    case EVENT_PHASE_CHANGE:
+        printf("State changed at %u ms. Phase: %u, Controller: %s\n", record->time, record->phase,
+               record->controller < SIGNAL_CONTROLLER_TYPE_COUNT ? signalControllerName((SignalControllerType)record->controller) : "unknown");
+        break;
+    default:
+        printf("Unknown event %u at %u ms\n", record->type, record->time);
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = argc > 1 ? argv[1] : EVENT_LOG_DEFAULT_PATH;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror("Failed to open event log");
+        return 1;
+    }
+
+    EventLogHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic)) != 0)
+    {
+        fprintf(stderr, "%s is not an event log\n", path);
+        fclose(file);
+        return 1;
+    }
+    if (header.version != EVENT_LOG_VERSION || header.recordSize != sizeof(EventRecord))
+    {
+        fprintf(stderr, "%s has version %u with %u-byte records, expected version %d with %u-byte records\n",
+                path, header.version, header.recordSize, EVENT_LOG_VERSION, (unsigned)sizeof(EventRecord));
+        fclose(file);
+        return 1;
+    }
+
+    EventRecord record;
+    Uint32 count = 0;
+    while (fread(&record, sizeof(record), 1, file) == 1)
+    {
+        printEvent(&record);
+        count++;
+    }
+    fclose(file);
+
+    fprintf(stderr, "%u events\n", count);
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <string.h>
+#include "frame_capture.h"
+#include "profiler.h"
+
+static void writeY4mFrame(FrameCapture *capture, const Uint8 *rgb)
+{
+    // BT.601 studio-range conversion into planar Y, U and V
+    int pixelCount = capture->width * capture->height;
+    Uint8 *yPlane = capture->planes;
+    Uint8 *uPlane = yPlane + pixelCount;
+    Uint8 *vPlane = uPlane + pixelCount;
+
+    for (int i = 0; i < pixelCount; i++)
+    {
+        int r = rgb[i * 3];
+        int g = rgb[i * 3 + 1];
+        int b = rgb[i * 3 + 2];
+        yPlane[i] = (Uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        uPlane[i] = (Uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        vPlane[i] = (Uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+
+    fputs("FRAME\n", capture->file);
+    fwrite(capture->planes, 1, (size_t)pixelCount * 3, capture->file);
+}
+
+static void writePpmFrame(FrameCapture *capture, const Uint8 *rgb, Uint32 frameIndex)
+{
+    char name[CAPTURE_PATH_LENGTH + 16];
+    snprintf(name, sizeof(name), "%s%06u.ppm", capture->path, frameIndex);
+
+    FILE *file = fopen(name, "wb");
+    if (file == NULL)
+    {
+        perror("Failed to write capture frame");
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", capture->width, capture->height);
+    fwrite(rgb, 1, (size_t)capture->width * capture->height * 3, file);
+    fclose(file);
+}
+
+static int captureWorker(void *data)
+{
+    FrameCapture *capture = (FrameCapture *)data;
+
+    SDL_LockMutex(capture->lock);
+    for (;;)
+    {
+        while (capture->pendingCount == 0 && !capture->stopping)
+        {
+            SDL_CondWait(capture->changed, capture->lock);
+        }
+        if (capture->pendingCount == 0)
+            break; // Stopping and fully drained
+
+        int buffer = capture->pendingBuffers[capture->pendingHead];
+        Uint32 frameIndex = capture->pendingFrames[capture->pendingHead];
+        capture->pendingHead = (capture->pendingHead + 1) % CAPTURE_POOL_SIZE;
+        capture->pendingCount--;
+        SDL_UnlockMutex(capture->lock);
+
+        // Encode outside the lock so the render thread can keep queueing frames
+        PROFILE_BEGIN(PROFILE_CAPTURE_WRITE);
+        if (capture->format == CAPTURE_Y4M)
+            writeY4mFrame(capture, capture->buffers[buffer]);
+        else
+            writePpmFrame(capture, capture->buffers[buffer], frameIndex);
+        PROFILE_END(PROFILE_CAPTURE_WRITE);
+
+        SDL_LockMutex(capture->lock);
+        capture->freeBuffers[capture->freeCount++] = buffer;
+        capture->framesWritten++;
+    }
+    SDL_UnlockMutex(capture->lock);
+    return 0;
+}
+
+FrameCapture *startFrameCapture(const char *path, CaptureFormat format, int width, int height, int fps)
+{
+    FrameCapture *capture = (FrameCapture *)calloc(1, sizeof(FrameCapture));
+    if (capture == NULL)
+        return NULL;
+
+    capture->format = format;
+    capture->width = width;
+    capture->height = height;
+    SDL_strlcpy(capture->path, path, sizeof(capture->path));
+
+    size_t frameBytes = (size_t)width * height * 3;
+    bool buffersReady = true;
+    for (int i = 0; i < CAPTURE_POOL_SIZE; i++)
+    {
+        capture->buffers[i] = (Uint8 *)malloc(frameBytes);
+        capture->freeBuffers[i] = i;
+        buffersReady = buffersReady && capture->buffers[i] != NULL;
+    }
+    capture->freeCount = CAPTURE_POOL_SIZE;
+
+    if (format == CAPTURE_Y4M)
+    {
+        capture->planes = (Uint8 *)malloc(frameBytes);
+        capture->file = fopen(path, "wb");
+        if (capture->file != NULL)
+        {
+            fprintf(capture->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+        }
+    }
+
+    if (format == CAPTURE_Y4M)
+    {
+        buffersReady = buffersReady && capture->planes != NULL && capture->file != NULL;
+    }
+    capture->lock = SDL_CreateMutex();
+    capture->changed = SDL_CreateCond();
+    if (buffersReady && capture->lock != NULL && capture->changed != NULL)
+    {
+        capture->worker = SDL_CreateThread(captureWorker, "capture", capture);
+    }
+    if (capture->worker == NULL)
+    {
+        fprintf(stderr, "Failed to start frame capture to %s\n", path);
+        stopFrameCapture(capture);
+        return NULL;
+    }
+    return capture;
+}
+
+void captureFrame(FrameCapture *capture, SDL_Renderer *renderer)
+{
+    capture->framesOffered++;
+
+    // Take a free buffer, or drop the frame rather than wait for the encoder
+    SDL_LockMutex(capture->lock);
+    int buffer = capture->freeCount > 0 ? capture->freeBuffers[--capture->freeCount] : -1;
+    SDL_UnlockMutex(capture->lock);
+    if (buffer < 0)
+    {
+        capture->framesDropped++;
+        return;
+    }
+
+    SDL_Rect area = {0, 0, capture->width, capture->height};
+    if (SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_RGB24, capture->buffers[buffer], capture->width * 3) != 0)
+    {
+        SDL_LockMutex(capture->lock);
+        capture->freeBuffers[capture->freeCount++] = buffer;
+        SDL_UnlockMutex(capture->lock);
+        capture->framesDropped++;
+        return;
+    }
+
+    SDL_LockMutex(capture->lock);
+    int tail = (capture->pendingHead + capture->pendingCount) % CAPTURE_POOL_SIZE;
+    capture->pendingBuffers[tail] = buffer;
+    capture->pendingFrames[tail] = capture->framesOffered - 1;
+    capture->pendingCount++;
+    SDL_CondSignal(capture->changed);
+    SDL_UnlockMutex(capture->lock);
+}
+
+void stopFrameCapture(FrameCapture *capture)
+{
+    if (capture == NULL)
+        return;
+
+    if (capture->worker != NULL)
+    {
+        // Let the worker drain whatever is still queued before it exits
+        SDL_LockMutex(capture->lock);
+        capture->stopping = true;
+        SDL_CondSignal(capture->changed);
+        SDL_UnlockMutex(capture->lock);
+        SDL_WaitThread(capture->worker, NULL);
+
+        printf("Capture %s: %u frames written, %u dropped\n", capture->path, capture->framesWritten, capture->framesDropped);
+    }
+
+    if (capture->file != NULL)
+        fclose(capture->file);
+    if (capture->changed != NULL)
+        SDL_DestroyCond(capture->changed);
+    if (capture->lock != NULL)
+        SDL_DestroyMutex(capture->lock);
+    for (int i = 0; i < CAPTURE_POOL_SIZE; i++)
+        free(capture->buffers[i]);
+    free(capture->planes);
+    free(capture);
+}
@@ -0,0 +1,46 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define CAPTURE_POOL_SIZE 4
+#define CAPTURE_PATH_LENGTH 260
+
+typedef enum {
+    CAPTURE_Y4M,           // Single YUV4MPEG2 (4:4:4) video file
+    CAPTURE_PPM_SEQUENCE   // One binary PPM image per frame, path is used as the file name prefix
+} CaptureFormat;
+
+// Reads rendered frames back into a fixed pool of reusable buffers and hands
+// them to a worker thread for encoding, so disk I/O never stalls the render
+// loop. When every buffer is still queued the frame is dropped and counted.
+typedef struct {
+    CaptureFormat format;
+    char path[CAPTURE_PATH_LENGTH];
+    FILE *file;
+    int width;
+    int height;
+    Uint8 *buffers[CAPTURE_POOL_SIZE];   // RGB24 frames
+    Uint8 *planes;                       // Y4M conversion scratch, owned by the worker
+    int freeBuffers[CAPTURE_POOL_SIZE];
+    int freeCount;
+    int pendingBuffers[CAPTURE_POOL_SIZE];
+    Uint32 pendingFrames[CAPTURE_POOL_SIZE];
+    int pendingHead;
+    int pendingCount;
+    SDL_mutex *lock;
+    SDL_cond *changed;
+    SDL_Thread *worker;
+    bool stopping;
+    Uint32 framesOffered;
+    Uint32 framesWritten;
+    Uint32 framesDropped;
+} FrameCapture;
+
+FrameCapture* startFrameCapture(const char* path, CaptureFormat format, int width, int height, int fps);
+void captureFrame(FrameCapture* capture, SDL_Renderer* renderer);
+void stopFrameCapture(FrameCapture* capture);
+
+#endif
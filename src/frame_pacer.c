@@ -0,0 +1,59 @@
+#include "frame_pacer.h"
+
+void initFramePacer(FramePacer *pacer, int targetFps, bool vsync)
+{
+    if (targetFps <= 0)
+        targetFps = DEFAULT_TARGET_FPS;
+
+    pacer->frequency = SDL_GetPerformanceFrequency();
+    pacer->frameBudget = pacer->frequency / targetFps;
+    pacer->frameStart = SDL_GetPerformanceCounter();
+    pacer->lastFrameTime = 0;
+    pacer->lastWorkTime = 0;
+    pacer->framesRendered = 0;
+    pacer->framesDropped = 0;
+    pacer->vsync = vsync;
+}
+
+void beginFrame(FramePacer *pacer)
+{
+    pacer->frameStart = SDL_GetPerformanceCounter();
+}
+
+void endFrame(FramePacer *pacer)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 deadline = pacer->frameStart + pacer->frameBudget;
+    pacer->lastWorkTime = now - pacer->frameStart;
+
+    if (!pacer->vsync && now < deadline)
+    {
+        // Sleep for the whole milliseconds left, leaving one spare to absorb scheduler jitter
+        Uint32 remainingMs = (Uint32)((deadline - now) * 1000 / pacer->frequency);
+        if (remainingMs > 1)
+        {
+            SDL_Delay(remainingMs - 1);
+        }
+
+        // Then yield until the deadline for the sub-millisecond remainder
+        while (SDL_GetPerformanceCounter() < deadline)
+        {
+            SDL_Delay(0);
+        }
+        now = SDL_GetPerformanceCounter();
+    }
+
+    pacer->lastFrameTime = now - pacer->frameStart;
+    pacer->framesRendered++;
+
+    // A frame that overran its budget by more than half a frame missed at least one display refresh
+    if (pacer->lastFrameTime > pacer->frameBudget + pacer->frameBudget / 2)
+    {
+        pacer->framesDropped++;
+    }
+}
+
+float framePacerMilliseconds(const FramePacer *pacer, Uint64 ticks)
+{
+    return (float)(ticks * 1000.0 / pacer->frequency);
+}
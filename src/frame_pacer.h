@@ -0,0 +1,27 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define DEFAULT_TARGET_FPS 60
+
+// Keeps the render loop at a target frame rate by sleeping only for whatever
+// is left of the frame budget, and counts frames that missed their deadline.
+typedef struct {
+    Uint64 frequency;
+    Uint64 frameBudget;      // Performance counter ticks per frame
+    Uint64 frameStart;
+    Uint64 lastFrameTime;    // Duration of the last complete frame, including the sleep
+    Uint64 lastWorkTime;     // Duration of the last frame before sleeping
+    Uint32 framesRendered;
+    Uint32 framesDropped;
+    bool vsync;              // Present already blocks on the display, so never sleep
+} FramePacer;
+
+void initFramePacer(FramePacer* pacer, int targetFps, bool vsync);
+void beginFrame(FramePacer* pacer);
+void endFrame(FramePacer* pacer);
+float framePacerMilliseconds(const FramePacer* pacer, Uint64 ticks);
+
+#endif
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+#include "headless.h"
+#include "frame_capture.h"
+#include "state_hash.h"
+#include "event_log.h"
+
+static void releaseHeadlessRenderer(SDL_Renderer *renderer, SDL_Surface *surface)
+{
+    if (renderer != NULL)
+    {
+        destroyRenderCaches();
+        SDL_DestroyRenderer(renderer);
+    }
+    SDL_FreeSurface(surface);
+    SDL_Quit();
+}
+
+int runHeadless(const HeadlessOptions *options)
+{
+    if (SDL_Init(0) != 0)
+    {
+        fprintf(stderr, "Failed to initialise SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // Simulation state and snapshots are too large for the stack
+    static Simulation simulation;
+    static SimulationSnapshot snapshot;
+    initSimulation(&simulation);
+
+    SDL_Surface *surface = NULL;
+    SDL_Renderer *renderer = NULL;
+    FrameCapture *capture = NULL;
+    RenderView view;
+    view.lodMode = LOD_AUTO;
+    resetCamera(&view.camera);
+
+    if (options->frameInterval > 0)
+    {
+        surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_RGBA8888);
+        renderer = surface != NULL ? SDL_CreateSoftwareRenderer(surface) : NULL;
+        if (renderer == NULL)
+        {
+            fprintf(stderr, "Failed to create offscreen renderer: %s\n", SDL_GetError());
+            releaseHeadlessRenderer(renderer, surface);
+            return 1;
+        }
+
+        // Played back at one frame per rendered interval of simulated time
+        size_t length = strlen(options->outputPath);
+        CaptureFormat format = (length >= 4 && strcmp(options->outputPath + length - 4, ".y4m") == 0) ? CAPTURE_Y4M : CAPTURE_PPM_SEQUENCE;
+        int fps = simulationTickRate / options->frameInterval;
+        capture = startFrameCapture(options->outputPath, format, WINDOW_WIDTH, WINDOW_HEIGHT, fps > 0 ? fps : 1);
+        if (capture == NULL)
+        {
+            fprintf(stderr, "Headless run stopped, no frames can be captured to %s\n", options->outputPath);
+            releaseHeadlessRenderer(renderer, surface);
+            return 1;
+        }
+    }
+
+    // One line per tick, so the logs of two builds can be compared with diff
+    FILE *hashLog = NULL;
+    if (options->hashLogPath != NULL)
+    {
+        hashLog = fopen(options->hashLogPath, "w");
+        if (hashLog == NULL)
+        {
+            perror("Failed to open hash log");
+            stopFrameCapture(capture);
+            releaseHeadlessRenderer(renderer, surface);
+            return 1;
+        }
+    }
+
+    // The ring is allocated here rather than by the first event inside a tick
+    registerEventLogThread();
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 simulationCounter = 0;
+    Uint64 renderCounter = 0;
+
+    for (int tick = 0; tick < options->ticks; tick++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        stepSimulation(&simulation);
+        simulationCounter += SDL_GetPerformanceCounter() - start;
+
+        if (hashLog != NULL)
+        {
+            fprintf(hashLog, "%u %016llx\n", simulation.tick, (unsigned long long)hashSimulationState(&simulation));
+        }
+
+        if (capture != NULL && (tick + 1) % options->frameInterval == 0)
+        {
+            // Timed from here, so the hash log write counts toward neither share
+            Uint64 rendering = SDL_GetPerformanceCounter();
+            captureSnapshot(&simulation, &snapshot);
+            snapshot.tickDuration = 0; // Draw exactly this tick, no interpolation
+            renderSimulation(renderer, &snapshot, &view);
+            captureFrame(capture, renderer);
+            renderCounter += SDL_GetPerformanceCounter() - rendering;
+        }
+    }
+
+    stopFrameCapture(capture);
+    if (hashLog != NULL)
+    {
+        fclose(hashLog);
+    }
+
+    double simulationSeconds = (double)simulationCounter / frequency;
+    double renderSeconds = (double)renderCounter / frequency;
+    double totalSeconds = simulationSeconds + renderSeconds;
+    printf("Headless run: %d ticks (%.1f s simulated), %d vehicles passed\n",
+           options->ticks, simulation.time / 1000.0, simulation.stats.vehiclesPassed);
+    printf("Simulation %.3f s, rendering %.3f s (%.1f%% of run)\n",
+           simulationSeconds, renderSeconds, totalSeconds > 0 ? 100.0 * renderSeconds / totalSeconds : 0.0);
+
+    releaseHeadlessRenderer(renderer, surface);
+    return 0;
+}
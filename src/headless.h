@@ -0,0 +1,22 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "traffic_simulation.h"
+
+#define HEADLESS_DEFAULT_TICKS (SIM_TICK_RATE * 60)
+#define HEADLESS_DEFAULT_FRAME_INTERVAL SIM_TICK_RATE
+#define HEADLESS_DEFAULT_OUTPUT "frame_"
+
+typedef struct {
+    int ticks;              // Simulation horizon
+    int frameInterval;      // Render every Nth tick, 0 disables rendering
+    const char* outputPath; // .y4m for a video, otherwise a prefix for numbered PPM images
+    const char* hashLogPath; // Write the state hash after every tick, NULL to skip
+} HeadlessOptions;
+
+// Runs the simulation as fast as possible without a window. Selected ticks are
+// drawn with a software renderer onto an offscreen surface and written out
+// asynchronously, so visual output costs a bounded fraction of the run.
+int runHeadless(const HeadlessOptions* options);
+
+#endif
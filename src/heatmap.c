@@ -0,0 +1,81 @@
+#include <string.h>
+#include "heatmap.h"
+
+#define HEATMAP_COUNT_STEP 48 // Palette steps per vehicle in a cell
+
+static SDL_Texture *heatmapTexture = NULL;
+static Uint16 occupancy[HEATMAP_ROWS][HEATMAP_COLUMNS];
+static Uint32 heatmapPixels[HEATMAP_ROWS][HEATMAP_COLUMNS];
+static Uint32 palette[256];
+static bool paletteReady = false;
+
+static void buildPalette(void)
+{
+    // Transparent for empty cells, then green through yellow to red with rising opacity
+    palette[0] = 0;
+    for (int i = 1; i < 256; i++)
+    {
+        Uint32 r = (i < 128) ? i * 2 : 255;
+        Uint32 g = (i < 128) ? 255 : (255 - i) * 2;
+        Uint32 a = 96 + i * 159 / 255;
+        palette[i] = (r << 24) | (g << 16) | (0 << 8) | a;
+    }
+    paletteReady = true;
+}
+
+void renderHeatmap(SDL_Renderer *renderer, const Vehicle *vehicles, const SDL_FRect *destination)
+{
+    if (!paletteReady)
+    {
+        buildPalette();
+    }
+    if (heatmapTexture == NULL)
+    {
+        heatmapTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, HEATMAP_COLUMNS, HEATMAP_ROWS);
+        if (heatmapTexture == NULL)
+            return;
+        SDL_SetTextureBlendMode(heatmapTexture, SDL_BLENDMODE_BLEND);
+    }
+
+    // Accumulate vehicle centres into the occupancy grid
+    memset(occupancy, 0, sizeof(occupancy));
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        if (!vehicles[i].active)
+            continue;
+        // Floored, so centres just left of or above the window fall outside rather than into cell 0
+        int column = (int)SDL_floorf((vehicles[i].x + vehicles[i].rect.w / 2) / HEATMAP_CELL_SIZE);
+        int row = (int)SDL_floorf((vehicles[i].y + vehicles[i].rect.h / 2) / HEATMAP_CELL_SIZE);
+        if (column >= 0 && column < HEATMAP_COLUMNS && row >= 0 && row < HEATMAP_ROWS && occupancy[row][column] < 0xFFFF)
+        {
+            occupancy[row][column]++;
+        }
+    }
+
+    for (int row = 0; row < HEATMAP_ROWS; row++)
+    {
+        for (int column = 0; column < HEATMAP_COLUMNS; column++)
+        {
+            int level = occupancy[row][column] * HEATMAP_COUNT_STEP;
+            heatmapPixels[row][column] = palette[level > 255 ? 255 : level];
+        }
+    }
+
+    SDL_UpdateTexture(heatmapTexture, NULL, heatmapPixels, HEATMAP_COLUMNS * sizeof(Uint32));
+    SDL_RenderCopyF(renderer, heatmapTexture, NULL, destination);
+}
+
+void invalidateHeatmap(void)
+{
+    // A device reset leaves the texture unusable, the next render creates a new one
+    destroyHeatmap();
+}
+
+void destroyHeatmap(void)
+{
+    if (heatmapTexture != NULL)
+    {
+        SDL_DestroyTexture(heatmapTexture);
+        heatmapTexture = NULL;
+    }
+}
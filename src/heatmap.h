@@ -0,0 +1,18 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "traffic_simulation.h"
+
+#define HEATMAP_CELL_SIZE 8
+#define HEATMAP_COLUMNS (WINDOW_WIDTH / HEATMAP_CELL_SIZE)
+#define HEATMAP_ROWS (WINDOW_HEIGHT / HEATMAP_CELL_SIZE)
+
+// Level-of-detail vehicle renderer: vehicle counts are accumulated into a
+// coarse occupancy grid which is uploaded as one streaming texture, so the
+// draw cost no longer depends on the number of vehicles.
+void renderHeatmap(SDL_Renderer* renderer, const Vehicle* vehicles, const SDL_FRect* destination);
+// Drops the texture after a render reset, the next render creates it again
+void invalidateHeatmap(void);
+void destroyHeatmap(void);
+
+#endif
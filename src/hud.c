@@ -0,0 +1,350 @@
+#include <string.h>
+#include "hud.h"
+
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+#define GLYPH_CELL_WIDTH (GLYPH_WIDTH + 1)
+#define GLYPH_CELL_HEIGHT (GLYPH_HEIGHT + 1)
+#define HUD_SCALE 2
+#define HUD_ADVANCE (GLYPH_CELL_WIDTH * HUD_SCALE)
+#define HUD_LINE_HEIGHT ((GLYPH_CELL_HEIGHT + 2) * HUD_SCALE)
+#define HUD_MAX_GLYPHS 640
+#define HUD_PANEL_X 10
+#define HUD_LINES 6
+#define HUD_PROFILE_LINES (PROFILE_FRAME_STAGES + 1)
+#define HUD_PROFILE_REFRESH 250  // Milliseconds between updates of the stage timings
+#define HUD_PANEL_WIDTH 330
+#define HUD_PANEL_HEIGHT(lines) ((lines) * HUD_LINE_HEIGHT + 10)
+#define HUD_PANEL_Y(lines) (WINDOW_HEIGHT - (lines) * HUD_LINE_HEIGHT - 20)
+
+// Glyph bitmaps, one byte per row with the leftmost pixel in bit 4
+static const char GLYPH_CHARS[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/-";
+static const Uint8 GLYPH_ROWS[][GLYPH_HEIGHT] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // A
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // B
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // C
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // D
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // E
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // F
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // G
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // H
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // L
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // N
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // O
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // P
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // Q
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // R
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // S
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // W
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // X
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}, // Y
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // Z
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // :
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // /
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // -
+};
+#define GLYPH_COUNT ((int)(sizeof(GLYPH_ROWS) / sizeof(GLYPH_ROWS[0])))
+#define SOLID_GLYPH GLYPH_COUNT // Fully opaque cell after the last glyph, used for the panel
+#define ATLAS_WIDTH ((GLYPH_COUNT + 1) * GLYPH_CELL_WIDTH)
+#define ATLAS_HEIGHT GLYPH_CELL_HEIGHT
+
+static SDL_Texture *glyphAtlas = NULL;
+static Uint8 glyphLookup[128];
+static SDL_Vertex hudVertices[HUD_MAX_GLYPHS * 6];
+static int hudVertexCount = 0;
+
+bool initHud(SDL_Renderer *renderer)
+{
+    static Uint32 pixels[ATLAS_HEIGHT][ATLAS_WIDTH];
+    memset(pixels, 0, sizeof(pixels));
+
+    for (int glyph = 0; glyph < GLYPH_COUNT; glyph++)
+    {
+        for (int row = 0; row < GLYPH_HEIGHT; row++)
+        {
+            for (int col = 0; col < GLYPH_WIDTH; col++)
+            {
+                if (GLYPH_ROWS[glyph][row] & (0x10 >> col))
+                {
+                    pixels[row][glyph * GLYPH_CELL_WIDTH + col] = 0xFFFFFFFF;
+                }
+            }
+        }
+    }
+    for (int row = 0; row < ATLAS_HEIGHT; row++)
+    {
+        for (int col = 0; col < GLYPH_CELL_WIDTH; col++)
+        {
+            pixels[row][SOLID_GLYPH * GLYPH_CELL_WIDTH + col] = 0xFFFFFFFF;
+        }
+    }
+
+    // Unknown characters render as blanks
+    memset(glyphLookup, 0, sizeof(glyphLookup));
+    for (int i = 0; GLYPH_CHARS[i] != '\0'; i++)
+    {
+        glyphLookup[(int)GLYPH_CHARS[i]] = (Uint8)i;
+    }
+
+    glyphAtlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, ATLAS_WIDTH, ATLAS_HEIGHT);
+    if (glyphAtlas == NULL)
+    {
+        return false;
+    }
+    SDL_UpdateTexture(glyphAtlas, NULL, pixels, ATLAS_WIDTH * sizeof(Uint32));
+    SDL_SetTextureBlendMode(glyphAtlas, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void destroyHud(void)
+{
+    if (glyphAtlas != NULL)
+    {
+        SDL_DestroyTexture(glyphAtlas);
+        glyphAtlas = NULL;
+    }
+}
+
+static void addQuad(float x, float y, float w, float h, int glyph, SDL_Color color)
+{
+    if (hudVertexCount + 6 > HUD_MAX_GLYPHS * 6)
+        return;
+
+    float u0 = (float)(glyph * GLYPH_CELL_WIDTH) / ATLAS_WIDTH;
+    float u1 = (float)(glyph * GLYPH_CELL_WIDTH + GLYPH_CELL_WIDTH) / ATLAS_WIDTH;
+    float v0 = 0.0f;
+    float v1 = 1.0f;
+    if (glyph == SOLID_GLYPH)
+    {
+        // Sample well inside the cell so filtering never picks up a neighbouring glyph
+        u0 = u1 = (glyph * GLYPH_CELL_WIDTH + GLYPH_CELL_WIDTH / 2.0f) / ATLAS_WIDTH;
+        v0 = v1 = 0.5f;
+    }
+
+    SDL_Vertex corners[4] = {
+        {{x, y}, color, {u0, v0}},
+        {{x + w, y}, color, {u1, v0}},
+        {{x + w, y + h}, color, {u1, v1}},
+        {{x, y + h}, color, {u0, v1}},
+    };
+    SDL_Vertex *out = &hudVertices[hudVertexCount];
+    out[0] = corners[0];
+    out[1] = corners[1];
+    out[2] = corners[2];
+    out[3] = corners[0];
+    out[4] = corners[2];
+    out[5] = corners[3];
+    hudVertexCount += 6;
+}
+
+static float addText(float x, float y, const char *text, SDL_Color color)
+{
+    for (; *text != '\0'; text++)
+    {
+        int glyph = glyphLookup[(Uint8)*text & 0x7F];
+        if (glyph != 0)
+        {
+            addQuad(x, y, GLYPH_CELL_WIDTH * HUD_SCALE, GLYPH_CELL_HEIGHT * HUD_SCALE, glyph, color);
+        }
+        x += HUD_ADVANCE;
+    }
+    return x;
+}
+
+// Emits digits straight into glyph quads, so numbers never go through printf formatting
+static float addNumber(float x, float y, int value, int minDigits, SDL_Color color)
+{
+    char digits[12];
+    int count = 0;
+    bool negative = value < 0;
+    unsigned int magnitude = negative ? 0u - (unsigned int)value : (unsigned int)value;
+
+    do
+    {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0 && count < 11);
+    while (count < minDigits && count < 11)
+    {
+        digits[count++] = '0';
+    }
+
+    if (negative)
+        x = addText(x, y, "-", color);
+    while (count > 0)
+    {
+        addQuad(x, y, GLYPH_CELL_WIDTH * HUD_SCALE, GLYPH_CELL_HEIGHT * HUD_SCALE, glyphLookup[(int)digits[--count]], color);
+        x += HUD_ADVANCE;
+    }
+    return x;
+}
+
+static float addDecimal(float x, float y, float value, SDL_Color color)
+{
+    int tenths = (int)(value * 10.0f + 0.5f);
+    x = addNumber(x, y, tenths / 10, 1, color);
+    x = addText(x, y, ".", color);
+    return addNumber(x, y, tenths % 10, 1, color);
+}
+
+static float addHundredths(float x, float y, float value, SDL_Color color)
+{
+    int hundredths = (int)(value * 100.0f + 0.5f);
+    x = addNumber(x, y, hundredths / 100, 1, color);
+    x = addText(x, y, ".", color);
+    return addNumber(x, y, hundredths % 100, 2, color);
+}
+
+#if PROFILER_ENABLED
+static ProfileSummary hudProfile[PROFILE_FRAME_STAGES];
+static Uint32 hudProfileRefreshed = 0;
+
+// Summaries walk every histogram bucket, so they are only refreshed a few
+// times a second. Each refresh requests a copy of the simulation stage
+// histograms, which the simulation thread takes between ticks in
+// publishTicks(); the copy is summarized here on the first frame it is ready.
+// Render stages are timed on this thread and summarized directly.
+static void refreshHudProfile(void)
+{
+    summarizeProfileCopy(hudProfile);
+
+    Uint32 now = SDL_GetTicks();
+    if (hudProfileRefreshed != 0 && now - hudProfileRefreshed < HUD_PROFILE_REFRESH)
+        return;
+    hudProfileRefreshed = now;
+    requestProfileCopy();
+    for (int i = PROFILE_SIMULATION_STAGES; i < PROFILE_FRAME_STAGES; i++)
+        summarizeProfile((ProfileStage)i, &hudProfile[i]);
+}
+
+// Mean and 99th percentile of the tick and frame stages, in microseconds. The
+// I/O stages are recorded on their own threads and only printed at exit.
+static float addProfile(float left, float y, SDL_Color color)
+{
+    refreshHudProfile();
+    addText(left, y, "PROFILE  MEAN / P99 US", color);
+    y += HUD_LINE_HEIGHT;
+
+    for (int i = 0; i < PROFILE_FRAME_STAGES; i++)
+    {
+        const ProfileSummary *summary = &hudProfile[i];
+        addText(left, y, profileStageLabel((ProfileStage)i), color);
+        float x = addNumber(left + 9 * HUD_ADVANCE, y, (int)(summary->meanMicroseconds + 0.5f), 1, color);
+        x = addText(x, y, " / ", color);
+        addNumber(x, y, (int)(summary->p99Microseconds + 0.5f), 1, color);
+        y += HUD_LINE_HEIGHT;
+    }
+    return y;
+}
+#endif
+
+void renderHud(SDL_Renderer *renderer, const SimulationSnapshot *snapshot, const FramePacer *pacer, bool showProfile)
+{
+    if (glyphAtlas == NULL)
+        return;
+
+    const SDL_Color panel = {0, 0, 0, 160};
+    const SDL_Color text = {255, 255, 255, 255};
+    const SDL_Color highlight = {255, 220, 0, 255};
+    hudVertexCount = 0;
+
+#if PROFILER_ENABLED
+    int lines = showProfile ? HUD_LINES + HUD_PROFILE_LINES : HUD_LINES;
+#else
+    (void)showProfile;
+    int lines = HUD_LINES;
+#endif
+    addQuad(HUD_PANEL_X, HUD_PANEL_Y(lines), HUD_PANEL_WIDTH, HUD_PANEL_HEIGHT(lines), SOLID_GLYPH, panel);
+
+    float left = HUD_PANEL_X + 8;
+    float y = HUD_PANEL_Y(lines) + 8;
+    float x;
+
+#if PROFILER_ENABLED
+    if (showProfile)
+        y = addProfile(left, y, text);
+#endif
+
+    // Simulated time and speed
+    Uint32 seconds = snapshot->simulationTime / 1000;
+    x = addText(left, y, "SIM ", text);
+    x = addNumber(x, y, (int)(seconds / 60), 2, text);
+    x = addText(x, y, ":", text);
+    x = addNumber(x, y, (int)(seconds % 60), 2, text);
+    x = addText(x, y, "  SPEED ", text);
+    if (snapshot->timeScale == TIME_SCALE_PAUSED)
+        addText(x, y, "PAUSED", highlight);
+    else if (snapshot->timeScale == TIME_SCALE_UNLIMITED)
+        addText(x, y, "MAX", highlight);
+    else
+        addText(addNumber(x, y, snapshot->timeScale, 1, highlight), y, "X", highlight);
+    y += HUD_LINE_HEIGHT;
+
+    // Throughput
+    x = addText(left, y, "PASSED ", text);
+    x = addNumber(x, y, snapshot->stats.vehiclesPassed, 1, text);
+    x = addText(x, y, "  VEH/MIN ", text);
+    addDecimal(x, y, snapshot->stats.vehiclesPerMinute, text);
+    y += HUD_LINE_HEIGHT;
+
+    // Per-lane queue lengths, lanes follow the direction order
+    static const char *laneLabels[4] = {"N ", " S ", " E ", " W "};
+    x = addText(left, y, "QUEUE ", text);
+    for (int i = 0; i < 4; i++)
+    {
+        x = addText(x, y, laneLabels[i], text);
+        x = addNumber(x, y, snapshot->queueLengths[i], 1, text);
+    }
+    y += HUD_LINE_HEIGHT;
+
+    // Longest current wait at a stop line and the average wait of discharged vehicles
+    Uint32 longestWait = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (snapshot->queueWaitTimes[i] > longestWait)
+            longestWait = snapshot->queueWaitTimes[i];
+    }
+    float averageWait = snapshot->stats.vehiclesDischarged > 0
+                            ? snapshot->stats.totalWaitTime / 1000.0f / snapshot->stats.vehiclesDischarged
+                            : 0.0f;
+    x = addText(left, y, "WAIT MAX ", text);
+    x = addDecimal(x, y, longestWait / 1000.0f, text);
+    x = addText(x, y, "S  AVG ", text);
+    x = addDecimal(x, y, averageWait, text);
+    addText(x, y, "S", text);
+    y += HUD_LINE_HEIGHT;
+
+    // Frame and tick timings
+    x = addText(left, y, "FRAME ", text);
+    x = addDecimal(x, y, framePacerMilliseconds(pacer, pacer->lastWorkTime), text);
+    x = addText(x, y, "MS  TICK ", text);
+    x = addHundredths(x, y, snapshot->tickMilliseconds, text);
+    addText(x, y, "MS", text);
+    y += HUD_LINE_HEIGHT;
+
+    x = addText(left, y, "FRAMES ", text);
+    x = addNumber(x, y, (int)pacer->framesRendered, 1, text);
+    x = addText(x, y, "  DROPPED ", text);
+    addNumber(x, y, (int)pacer->framesDropped, 1, pacer->framesDropped > 0 ? highlight : text);
+
+    SDL_RenderGeometry(renderer, glyphAtlas, hudVertices, hudVertexCount, NULL, 0);
+}
@@ -0,0 +1,13 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "traffic_simulation.h"
+#include "frame_pacer.h"
+
+// On-screen statistics overlay drawn from a pre-baked bitmap glyph atlas.
+// The panel and all text are submitted in a single textured geometry call.
+bool initHud(SDL_Renderer* renderer);
+void renderHud(SDL_Renderer* renderer, const SimulationSnapshot* snapshot, const FramePacer* pacer, bool showProfile);
+void destroyHud(void);
+
+#endif
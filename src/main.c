@@ -1,26 +1,171 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "traffic_simulation.h"
+#include "snapshot_buffer.h"
+#include "frame_pacer.h"
+#include "hud.h"
+#include "heatmap.h"
+#include "frame_capture.h"
+#include "headless.h"
+#include "event_log.h"
+#include "trace.h"
+#include "scenario.h"
+#include "state_hash.h"
 
-void initializeSDL(SDL_Window **window, SDL_Renderer **renderer) {
+#define CAMERA_PAN_STEP 40.0f   // Screen pixels per key press
+#define CAMERA_ZOOM_STEP 1.1f
+
+void initializeSDL(SDL_Window **window, SDL_Renderer **renderer, bool vsync) {
     SDL_Init(SDL_INIT_VIDEO);
     *window = SDL_CreateWindow("Traffic Simulation", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
-    *renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_ACCELERATED);
+    *renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
     SDL_SetRenderDrawColor(*renderer, 255, 255, 255, 255);
 }
 
 void cleanupSDL(SDL_Window *window, SDL_Renderer *renderer) {
+    destroyHud();
+    destroyRenderCaches();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 }
 
-void handleEvents(bool *running) {
+typedef struct {
+    Simulation *simulation;
+    SnapshotBuffer *snapshots;
+    SDL_atomic_t running;
+    SDL_atomic_t timeScale;     // Ticks per tick interval, TIME_SCALE_PAUSED or TIME_SCALE_UNLIMITED
+    SDL_atomic_t pendingSteps;  // Single steps requested while paused
+    int resumeScale;            // Scale restored when unpausing, only touched by the event loop
+    bool showHud;
+    bool showProfile;           // Stage timings on the HUD
+    RenderView view;
+    FrameCapture *capture;
+    int captureCount;           // Recordings started with the R key, used to name the files
+    int captureFps;
+} SimulationThreadContext;
+
+CaptureFormat captureFormatForPath(const char *path) {
+    size_t length = strlen(path);
+    return (length >= 4 && strcmp(path + length - 4, ".y4m") == 0) ? CAPTURE_Y4M : CAPTURE_PPM_SEQUENCE;
+}
+
+void toggleCapture(SimulationThreadContext *context) {
+    if (context->capture != NULL) {
+        stopFrameCapture(context->capture);
+        context->capture = NULL;
+        return;
+    }
+
+    char path[CAPTURE_PATH_LENGTH];
+    snprintf(path, sizeof(path), "capture_%03d.y4m", ++context->captureCount);
+    context->capture = startFrameCapture(path, CAPTURE_Y4M, WINDOW_WIDTH, WINDOW_HEIGHT, context->captureFps);
+    if (context->capture != NULL) {
+        printf("Recording to %s\n", path);
+    }
+}
+
+void setTimeScale(SimulationThreadContext *context, int scale) {
+    int current = SDL_AtomicGet(&context->timeScale);
+    if (scale == TIME_SCALE_PAUSED && current != TIME_SCALE_PAUSED) {
+        context->resumeScale = current;
+    }
+    SDL_AtomicSet(&context->timeScale, scale);
+}
+
+void handleKeyDown(SDL_Keycode key, SimulationThreadContext *context) {
+    switch (key) {
+    case SDLK_SPACE:
+        if (SDL_AtomicGet(&context->timeScale) == TIME_SCALE_PAUSED) {
+            setTimeScale(context, context->resumeScale);
+        } else {
+            setTimeScale(context, TIME_SCALE_PAUSED);
+        }
+        break;
+    case SDLK_PERIOD:
+    case SDLK_RIGHT:
+        // Single-step always pauses first so the step is observable
+        setTimeScale(context, TIME_SCALE_PAUSED);
+        SDL_AtomicAdd(&context->pendingSteps, 1);
+        break;
+    case SDLK_1:
+        setTimeScale(context, 1);
+        break;
+    case SDLK_2:
+        setTimeScale(context, 10);
+        break;
+    case SDLK_3:
+        setTimeScale(context, 100);
+        break;
+    case SDLK_4:
+        setTimeScale(context, TIME_SCALE_UNLIMITED);
+        break;
+    case SDLK_r:
+        toggleCapture(context);
+        break;
+    case SDLK_TAB:
+        context->showHud = !context->showHud;
+        break;
+    case SDLK_p:
+        context->showProfile = !context->showProfile;
+        break;
+    case SDLK_w:
+        panCamera(&context->view.camera, 0, -CAMERA_PAN_STEP);
+        break;
+    case SDLK_s:
+        panCamera(&context->view.camera, 0, CAMERA_PAN_STEP);
+        break;
+    case SDLK_a:
+        panCamera(&context->view.camera, -CAMERA_PAN_STEP, 0);
+        break;
+    case SDLK_d:
+        panCamera(&context->view.camera, CAMERA_PAN_STEP, 0);
+        break;
+    case SDLK_EQUALS:
+    case SDLK_KP_PLUS:
+        zoomCameraAt(&context->view.camera, CAMERA_ZOOM_STEP, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
+        break;
+    case SDLK_MINUS:
+    case SDLK_KP_MINUS:
+        zoomCameraAt(&context->view.camera, 1.0f / CAMERA_ZOOM_STEP, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
+        break;
+    case SDLK_0:
+        resetCamera(&context->view.camera);
+        break;
+    case SDLK_h:
+        // Cycle automatic level of detail, individual vehicles and the density heatmap
+        context->view.lodMode = (LodMode)((context->view.lodMode + 1) % LOD_MODE_COUNT);
+        break;
+    default:
+        break;
+    }
+}
+
+void handleEvents(bool *running, SimulationThreadContext *context) {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_QUIT) {
             *running = false;
+        } else if (event.type == SDL_KEYDOWN) {
+            handleKeyDown(event.key.keysym.sym, context);
+        } else if (event.type == SDL_MOUSEWHEEL && event.wheel.y != 0) {
+            // Zoom around the cursor
+            int mouseX, mouseY;
+            SDL_GetMouseState(&mouseX, &mouseY);
+            zoomCameraAt(&context->view.camera, event.wheel.y > 0 ? CAMERA_ZOOM_STEP : 1.0f / CAMERA_ZOOM_STEP, mouseX, mouseY);
+        } else if (event.type == SDL_MOUSEMOTION && (event.motion.state & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK))) {
+            // Drag to pan
+            panCamera(&context->view.camera, (float)-event.motion.xrel, (float)-event.motion.yrel);
+        } else if (event.type == SDL_RENDER_TARGETS_RESET) {
+            // Target contents were lost, re-rasterise the cached road layer
+            invalidateRoadLayer(false);
+            invalidateHeatmap();
+        } else if (event.type == SDL_RENDER_DEVICE_RESET ||
+                   (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+            invalidateRoadLayer(true);
+            invalidateHeatmap();
         }
     }
 }
@@ -52,103 +197,285 @@ Vehicle readVehicleFromFire(FILE *file) {
     return vehicle;
 }
 
-void simulationUpdate(Vehicle* vehicles, TrafficLight* lights) {
-    updateLanePositions(vehicles);
-    
-    // Update each vehicle
-    for (int i = 0; i < MAX_VEHICLES; i++) {
-        if (vehicles[i].active) {
-            updateVehicle(&vehicles[i], lights);
+void publishTicks(SimulationThreadContext *context, int scale) {
+    SimulationSnapshot *snapshot = beginSnapshotWrite(context->snapshots);
+    captureSnapshot(context->simulation, snapshot);
+    snapshot->timeScale = scale;
+    publishProfileCopy();
+
+    // Interpolation only makes sense when exactly one tick separates consecutive snapshots
+    if (scale != 1) {
+        snapshot->tickDuration = 0;
+    }
+    publishSnapshot(context->snapshots);
+}
+
+// Runs simulation ticks at a fixed rate, independent of how fast frames are presented.
+// At higher time scales several ticks run per interval and only the last one is published.
+int simulationThread(void *data) {
+    SimulationThreadContext *context = (SimulationThreadContext *)data;
+    Simulation *simulation = context->simulation;
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 tickInterval = frequency / simulationTickRate;
+    Uint64 nextTick = SDL_GetPerformanceCounter();
+    int publishedScale = 1;
+
+    // The ring is allocated here rather than by the first event inside a tick
+    registerEventLogThread();
+
+    while (SDL_AtomicGet(&context->running)) {
+        int scale = SDL_AtomicGet(&context->timeScale);
+
+        if (scale == TIME_SCALE_PAUSED) {
+            bool stepped = false;
+            if (SDL_AtomicGet(&context->pendingSteps) > 0) {
+                SDL_AtomicAdd(&context->pendingSteps, -1);
+                stepSimulation(simulation);
+                stepped = true;
+            }
+            if (stepped || publishedScale != scale) {
+                publishTicks(context, scale);
+                publishedScale = scale;
+            }
+            SDL_Delay(1);
+            nextTick = SDL_GetPerformanceCounter();
+            continue;
+        }
+
+        if (scale == TIME_SCALE_UNLIMITED) {
+            // Run flat out, publishing once per tick interval so the renderer still sees fresh state
+            Uint64 batchEnd = SDL_GetPerformanceCounter() + tickInterval;
+            do {
+                stepSimulation(simulation);
+            } while (SDL_GetPerformanceCounter() < batchEnd);
+        } else {
+            for (int i = 0; i < scale; i++) {
+                stepSimulation(simulation);
+            }
+        }
+        publishTicks(context, scale);
+        publishedScale = scale;
+
+        nextTick += tickInterval;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (nextTick > now) {
+            SDL_Delay((Uint32)((nextTick - now) * 1000 / frequency));
+        } else {
+            nextTick = now; // Running behind, don't try to catch up in a burst
         }
     }
-    
-    // Update traffic lights
-    updateTrafficLights(lights);
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
     SDL_Window *window = NULL;
     SDL_Renderer *renderer = NULL;
     bool running = true;
-    Uint32 lastVehicleSpawn = 0;
-    const Uint32 SPAWN_INTERVAL = 1000;
+    bool vsync = false;
+    int targetFps = DEFAULT_TARGET_FPS;
+    const char *capturePath = NULL;
+    const char *eventLogPath = NULL;
+    const char *tracePath = NULL;
+    bool perfCounters = false;
+    const Scenario *scenario = NULL;
+    bool ticksGiven = false;
+    const SimulationEngine *verifyEngine = NULL;
+    bool allocTracking = false;
+    int allocCheckAfterTick = -1;
+    bool headless = false;
+    HeadlessOptions headlessOptions;
+    headlessOptions.ticks = HEADLESS_DEFAULT_TICKS;
+    headlessOptions.frameInterval = HEADLESS_DEFAULT_FRAME_INTERVAL;
+    headlessOptions.outputPath = HEADLESS_DEFAULT_OUTPUT;
+    headlessOptions.hashLogPath = NULL;
 
     srand(time(NULL));
 
-    initializeSDL(&window, &renderer);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            setSimulationTickRate(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            targetFps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--vsync") == 0) {
+            vsync = true;
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            headlessOptions.ticks = atoi(argv[++i]);
+            ticksGiven = true;
+        } else if (strcmp(argv[i], "--frame-every") == 0 && i + 1 < argc) {
+            headlessOptions.frameInterval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--event-log") == 0 && i + 1 < argc) {
+            eventLogPath = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--perf-counters") == 0) {
+            perfCounters = true;
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenario = findScenario(argv[++i]);
+            if (scenario == NULL) {
+                fprintf(stderr, "Unknown scenario: %s. Scenarios:\n", argv[i]);
+                printScenarios(stderr);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--alloc-report") == 0) {
+            allocTracking = true;
+        } else if (strcmp(argv[i], "--alloc-check") == 0 && i + 1 < argc) {
+            allocTracking = true;
+            allocCheckAfterTick = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hash-log") == 0 && i + 1 < argc) {
+            headlessOptions.hashLogPath = argv[++i];
+        } else if (strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+            verifyEngine = findSimulationEngine(argv[++i]);
+            if (verifyEngine == NULL) {
+                fprintf(stderr, "Unknown simulation engine: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--controller") == 0 && i + 1 < argc) {
+            if (!findSignalController(argv[++i], &simulationControllerType)) {
+                fprintf(stderr, "Unknown signal controller: %s\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+
+    // A scenario fixes the seed and demand, and the headless horizon unless --ticks is given
+    if (scenario != NULL) {
+        applyScenario(scenario);
+        if (!ticksGiven) {
+            headlessOptions.ticks = scenarioTicks(scenario);
+        }
+        printf("Scenario %s: %s\n", scenario->name, scenario->description);
+    }
 
-    // Initialize vehicles
-    Vehicle vehicles[MAX_VEHICLES] = {0};
-    int vehicleCount = 0;
+    // Replays the engine against the reference tick and exits, nothing else runs
+    if (verifyEngine != NULL) {
+        Uint32 seed = scenario != NULL ? scenario->seed : (Uint32)time(NULL);
+        return verifySimulationEngine(verifyEngine, seed, headlessOptions.ticks) ? 0 : 1;
+    }
 
-    // Initialize traffic lights
-    TrafficLight lights[4];
-    initializeTrafficLights(lights);
+    // Everything allocated from here on is counted, a failed check fails the run
+    if (allocTracking && !startAllocTracking(allocCheckAfterTick)) {
+        return 1;
+    }
 
-    // Initialize statistics
-    Statistics stats = {
-        .vehiclesPassed = 0,
-        .totalVehicles = 0,
-        .vehiclesPerMinute = 0,
-        .startTime = SDL_GetTicks()
-    };
+    // Stage spans are buffered from here on and only written out at exit. A
+    // trace or counters that were asked for but cannot start fail the run.
+    if (tracePath != NULL && !startTrace(tracePath)) {
+        (void)stopAllocTracking();
+        return 1;
+    }
+    if (perfCounters && !startPerfCounters()) {
+        stopTrace();
+        (void)stopAllocTracking();
+        return 1;
+    }
 
-    // Initialize queues
-    for (int i = 0; i < 4; i++) {
-        initQueue(&laneQueues[i]);
+    // Light controller events are written in the background from here on. The
+    // writer thread reads the flags set above, so it starts after them.
+    if (eventLogPath != NULL && !startEventLog(eventLogPath)) {
+        stopPerfCounters();
+        stopTrace();
+        (void)stopAllocTracking();
+        return 1;
     }
 
-    while (running) {
-        handleEvents(&running);
-
-        // Spawn new vehicles periodically
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - lastVehicleSpawn >= SPAWN_INTERVAL && vehicleCount < MAX_VEHICLES) {
-            Direction spawnDirection = (Direction)(rand() % 4);
-            Vehicle* newVehicle = createVehicle(spawnDirection);
-            
-            // Find empty slot for new vehicle
-            for (int i = 0; i < MAX_VEHICLES; i++) {
-                if (!vehicles[i].active) {
-                    vehicles[i] = *newVehicle;
-                    vehicles[i].active = true;
-                    vehicleCount++;
-                    stats.totalVehicles++;
-                    break;
-                }
-            }
-            
-            free(newVehicle);
-            lastVehicleSpawn = currentTime;
+    if (headless) {
+        if (capturePath != NULL) {
+            headlessOptions.outputPath = capturePath;
         }
+        int result = runHeadless(&headlessOptions);
+        stopEventLog();
+        if (!stopAllocTracking()) {
+            result = 1;
+        }
+        printProfile();
+        stopPerfCounters();
+        stopTrace();
+        return result;
+    }
 
-        // Update vehicles
-        for (int i = 0; i < MAX_VEHICLES; i++) {
-            if (vehicles[i].active) {
-                updateVehicle(&vehicles[i], lights);
+    initializeSDL(&window, &renderer, vsync);
 
-                // Check if vehicle has passed through intersection
-                if (!vehicles[i].active) {
-                    stats.vehiclesPassed++;
-                    vehicleCount--;
-                }
-            }
-        }
+    // Simulation state and snapshots are too large for the stack
+    static Simulation simulation;
+    static SnapshotBuffer snapshots;
+    initSimulation(&simulation);
+    initSnapshotBuffer(&snapshots);
+
+    // Publish the initial state so the first frame has something to draw
+    captureSnapshot(&simulation, beginSnapshotWrite(&snapshots));
+    publishSnapshot(&snapshots);
+
+    SimulationThreadContext context;
+    context.simulation = &simulation;
+    context.snapshots = &snapshots;
+    SDL_AtomicSet(&context.running, 1);
+    SDL_AtomicSet(&context.timeScale, 1);
+    SDL_AtomicSet(&context.pendingSteps, 0);
+    context.resumeScale = 1;
+    context.showHud = initHud(renderer);
+    context.showProfile = false;
+    context.view.lodMode = LOD_AUTO;
+    resetCamera(&context.view.camera);
+    context.captureCount = 0;
+    context.captureFps = targetFps > 0 ? targetFps : DEFAULT_TARGET_FPS;
+    context.capture = NULL;
+    if (capturePath != NULL) {
+        context.capture = startFrameCapture(capturePath, captureFormatForPath(capturePath), WINDOW_WIDTH, WINDOW_HEIGHT, context.captureFps);
+    }
+    SDL_Thread *thread = SDL_CreateThread(simulationThread, "simulation", &context);
+    if (thread == NULL) {
+        fprintf(stderr, "Failed to create simulation thread: %s\n", SDL_GetError());
+        stopEventLog();
+        stopFrameCapture(context.capture);
+        stopPerfCounters();
+        stopTrace();
+        cleanupSDL(window, renderer);
+        return 1;
+    }
 
-        // Update traffic lights
-        updateTrafficLights(lights);
+    FramePacer pacer;
+    initFramePacer(&pacer, targetFps, vsync);
 
-        // Update statistics
-        float minutes = (SDL_GetTicks() - stats.startTime) / 60000.0f;
-        if (minutes > 0) {
-            stats.vehiclesPerMinute = stats.vehiclesPassed / minutes;
+    while (running) {
+        beginFrame(&pacer);
+        handleEvents(&running, &context);
+
+        // Render whichever tick the simulation thread published last
+        const SimulationSnapshot *snapshot = acquireLatestSnapshot(&snapshots);
+        renderSimulation(renderer, snapshot, &context.view);
+        if (context.showHud) {
+            PROFILE_BEGIN(PROFILE_RENDER_HUD);
+            renderHud(renderer, snapshot, &pacer, context.showProfile);
+            PROFILE_END(PROFILE_RENDER_HUD);
+        }
+
+        // Read back before presenting, the back buffer is undefined afterwards
+        if (context.capture != NULL) {
+            captureFrame(context.capture, renderer);
         }
-        simulationUpdate(vehicles, lights);
-        renderSimulation(renderer, vehicles, lights, &stats);
+        PROFILE_BEGIN(PROFILE_PRESENT);
+        SDL_RenderPresent(renderer);
+        PROFILE_END(PROFILE_PRESENT);
 
-        SDL_Delay(16); // Cap at ~60 FPS
+        // Sleep only for what is left of the frame budget
+        endFrame(&pacer);
     }
 
+    SDL_AtomicSet(&context.running, 0);
+    SDL_WaitThread(thread, NULL);
+
+    stopEventLog();
+    stopFrameCapture(context.capture);
+    bool allocationsPassed = stopAllocTracking();
+    printf("Rendered %u frames, dropped %u\n", pacer.framesRendered, pacer.framesDropped);
+    printProfile();
+    stopPerfCounters();
+    stopTrace();
+
     cleanupSDL(window, renderer);
-    return 0;
+    return allocationsPassed ? 0 : 1;
 }
\ No newline at end of file
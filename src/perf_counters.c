@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "perf_counters.h"
+#include "profiler.h"
+
+#if PERF_COUNTERS_ENABLED
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+typedef struct {
+    int fds[PERF_COUNTER_COUNT];  // The first one leads the group
+} PerfCounterGroup;
+
+// Layout of a PERF_FORMAT_GROUP read with the enabled and running times
+typedef struct {
+    Uint64 count;
+    Uint64 timeEnabled;
+    Uint64 timeRunning;
+    Uint64 values[PERF_COUNTER_COUNT];
+} PerfGroupRead;
+
+static const Uint64 PERF_COUNTER_EVENTS[PERF_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+static const char *PERF_COUNTER_NAMES[PERF_COUNTER_COUNT] = {
+    "cycles",
+    "instructions",
+    "cache-misses",
+    "branch-misses"};
+
+bool perfCountersActive = false;  // Only changed while no other thread is profiling
+
+// Each stage is recorded by one thread only, like its profile histogram
+static Uint64 perfTotals[PROFILE_STAGE_COUNT][PERF_COUNTER_COUNT];
+static Uint64 perfSamples[PROFILE_STAGE_COUNT];
+static Uint64 perfVehicleTicks = 0;
+static bool perfMultiplexed = false;
+
+static SDL_TLSID perfGroupKey = 0;
+static SDL_atomic_t perfGroupCount;
+static void *perfGroups[PERF_MAX_THREADS];
+
+static int openPerfCounter(Uint64 config, int groupFd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;  // Allowed without privileges at the default paranoia level
+    attr.exclude_hv = 1;
+
+    // Counts the calling thread only, on whichever CPU it runs
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+static void closePerfCounterGroup(PerfCounterGroup *group)
+{
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        if (group->fds[i] >= 0)
+            close(group->fds[i]);
+    }
+}
+
+// Opens the calling thread's counters on first use. A thread whose group
+// cannot be opened keeps a closed one and records nothing.
+static PerfCounterGroup *registerPerfCounterGroup(void)
+{
+    int index = SDL_AtomicAdd(&perfGroupCount, 1);
+    if (index >= PERF_MAX_THREADS)
+        return NULL;
+
+    PerfCounterGroup *group = (PerfCounterGroup *)malloc(sizeof(PerfCounterGroup));
+    if (group == NULL)
+        return NULL;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+        group->fds[i] = -1;
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        group->fds[i] = openPerfCounter(PERF_COUNTER_EVENTS[i], i == 0 ? -1 : group->fds[0]);
+        if (group->fds[i] < 0)
+        {
+            // Keep the reason for the caller, closing the partial group must not replace it
+            int error = errno;
+            closePerfCounterGroup(group);
+            for (int j = 0; j < PERF_COUNTER_COUNT; j++)
+                group->fds[j] = -1;
+            errno = error;
+            break;
+        }
+    }
+
+    SDL_TLSSet(perfGroupKey, group, NULL);
+    SDL_AtomicSetPtr(&perfGroups[index], group);
+    return group;
+}
+
+static bool readPerfCounterGroup(const PerfCounterGroup *group, PerfGroupRead *counts)
+{
+    return group->fds[0] >= 0 && read(group->fds[0], counts, sizeof(*counts)) == (ssize_t)sizeof(*counts);
+}
+
+static void printPerfCounters(void)
+{
+    if (perfSamples[PROFILE_TICK] == 0 && perfSamples[PROFILE_PRESENT] == 0)
+        return;
+
+    // Per sample is per tick for the simulation stages and per frame for the others
+    printf("%-20s %10s %12s %12s %6s %12s %12s\n", "counters per sample", "samples",
+           PERF_COUNTER_NAMES[PERF_CYCLES], PERF_COUNTER_NAMES[PERF_INSTRUCTIONS], "IPC",
+           PERF_COUNTER_NAMES[PERF_CACHE_MISSES], PERF_COUNTER_NAMES[PERF_BRANCH_MISSES]);
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++)
+    {
+        if (perfSamples[i] == 0)
+            continue;
+        const Uint64 *totals = perfTotals[i];
+        double samples = (double)perfSamples[i];
+        printf("%-20s %10llu %12.0f %12.0f %6.2f %12.1f %12.1f\n", profileStageName((ProfileStage)i),
+               (unsigned long long)perfSamples[i], totals[PERF_CYCLES] / samples, totals[PERF_INSTRUCTIONS] / samples,
+               totals[PERF_CYCLES] != 0 ? (double)totals[PERF_INSTRUCTIONS] / totals[PERF_CYCLES] : 0.0,
+               totals[PERF_CACHE_MISSES] / samples, totals[PERF_BRANCH_MISSES] / samples);
+    }
+
+    // The simulation stages again, divided by the vehicles active in each tick
+    if (perfVehicleTicks != 0)
+    {
+        printf("%-20s %10llu %12s %12s %6s %12s %12s\n", "counters per vehicle", (unsigned long long)perfVehicleTicks,
+               PERF_COUNTER_NAMES[PERF_CYCLES], PERF_COUNTER_NAMES[PERF_INSTRUCTIONS], "",
+               PERF_COUNTER_NAMES[PERF_CACHE_MISSES], PERF_COUNTER_NAMES[PERF_BRANCH_MISSES]);
+        double vehicles = (double)perfVehicleTicks;
+        for (int i = 0; i < PROFILE_SIMULATION_STAGES; i++)
+        {
+            if (perfSamples[i] == 0)
+                continue;
+            const Uint64 *totals = perfTotals[i];
+            printf("%-20s %10s %12.1f %12.1f %6s %12.3f %12.3f\n", profileStageName((ProfileStage)i), "",
+                   totals[PERF_CYCLES] / vehicles, totals[PERF_INSTRUCTIONS] / vehicles, "",
+                   totals[PERF_CACHE_MISSES] / vehicles, totals[PERF_BRANCH_MISSES] / vehicles);
+        }
+    }
+
+    if (perfMultiplexed)
+        printf("Counters were multiplexed with other perf users, totals only cover the time they were scheduled\n");
+}
+
+bool startPerfCounters(void)
+{
+    perfGroupKey = SDL_TLSCreate();
+    if (perfGroupKey == 0)
+    {
+        fprintf(stderr, "Failed to start hardware counters: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_AtomicSet(&perfGroupCount, 0);
+    memset(perfTotals, 0, sizeof(perfTotals));
+    memset(perfSamples, 0, sizeof(perfSamples));
+    perfVehicleTicks = 0;
+    perfMultiplexed = false;
+
+    // Open the starting thread's group now, so an unsupported host is reported before the run
+    errno = 0;
+    PerfCounterGroup *group = registerPerfCounterGroup();
+    if (group == NULL || group->fds[0] < 0)
+    {
+        fprintf(stderr, "Hardware counters unavailable: %s\n", errno != 0 ? strerror(errno) : "no thread slot");
+        stopPerfCounters();
+        return false;
+    }
+
+    perfCountersActive = true;
+    return true;
+}
+
+void stopPerfCounters(void)
+{
+    // Called once every profiled thread has finished
+    perfCountersActive = false;
+
+    int count = SDL_AtomicGet(&perfGroupCount);
+    for (int i = 0; i < count && i < PERF_MAX_THREADS; i++)
+    {
+        PerfCounterGroup *group = (PerfCounterGroup *)SDL_AtomicGetPtr(&perfGroups[i]);
+        if (group == NULL)
+            continue;
+
+        // A group that was not always on a PMU only counted part of the time
+        PerfGroupRead counts;
+        if (readPerfCounterGroup(group, &counts) && counts.timeRunning < counts.timeEnabled)
+            perfMultiplexed = true;
+
+        closePerfCounterGroup(group);
+        free(group);
+        SDL_AtomicSetPtr(&perfGroups[i], NULL);
+    }
+    SDL_AtomicSet(&perfGroupCount, 0);
+
+    printPerfCounters();
+}
+
+void readPerfCounters(PerfSample *sample)
+{
+    PerfCounterGroup *group = (PerfCounterGroup *)SDL_TLSGet(perfGroupKey);
+    if (group == NULL)
+        group = registerPerfCounterGroup();
+
+    PerfGroupRead counts;
+    if (group == NULL || !readPerfCounterGroup(group, &counts))
+    {
+        memset(sample, 0, sizeof(*sample));
+        return;
+    }
+    memcpy(sample->values, counts.values, sizeof(sample->values));
+}
+
+void recordPerfSpan(int stage, const PerfSample *start)
+{
+    PerfSample end;
+    readPerfCounters(&end);
+    if (end.values[PERF_CYCLES] == 0)
+        return;  // This thread has no counters
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+        perfTotals[stage][i] += end.values[i] - start->values[i];
+    perfSamples[stage]++;
+}
+
+void countPerfVehicles(int vehicles)
+{
+    perfVehicleTicks += (Uint64)vehicles;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Hardware counters are read with perf_event_open around profiled stages, so
+// they only exist on Linux builds with the profiler. Build with
+// -DPERF_COUNTERS_ENABLED=0 to compile the hooks out there too.
+#ifndef PERF_COUNTERS_ENABLED
+#if defined(__linux__) && (!defined(PROFILER_ENABLED) || PROFILER_ENABLED)
+#define PERF_COUNTERS_ENABLED 1
+#else
+#define PERF_COUNTERS_ENABLED 0
+#endif
+#endif
+
+#define PERF_MAX_THREADS 16
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+} PerfCounter;
+
+typedef struct {
+    Uint64 values[PERF_COUNTER_COUNT];
+} PerfSample;
+
+#if PERF_COUNTERS_ENABLED
+
+// The counters of the calling thread are read as one group when a profiled
+// stage begins and ends, and the difference is added to that stage's totals.
+// Reading costs a system call, so nothing is read unless they were started.
+// A stage's totals include the reads made by the stages nested in it, two per
+// nested span, which is only the tick among the simulation stages.
+// Stopping prints the totals per tick, per frame and per vehicle.
+bool startPerfCounters(void);
+void stopPerfCounters(void);
+void readPerfCounters(PerfSample* sample);
+void recordPerfSpan(int stage, const PerfSample* start);
+void countPerfVehicles(int vehicles);
+
+extern bool perfCountersActive;
+
+#define PERF_BEGIN(stage) PerfSample stage##_perf; if (perfCountersActive) readPerfCounters(&stage##_perf)
+#define PERF_END(stage) do { if (perfCountersActive) recordPerfSpan(stage, &stage##_perf); } while (0)
+#define PERF_COUNT_VEHICLES(vehicles) do { if (perfCountersActive) countPerfVehicles(vehicles); } while (0)
+
+#else
+
+#define startPerfCounters() (fputs("Hardware counters need a Linux build with the profiler\n", stderr), false)
+#define stopPerfCounters() ((void)0)
+#define PERF_BEGIN(stage)
+#define PERF_END(stage) ((void)0)
+#define PERF_COUNT_VEHICLES(vehicles) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <string.h>
+#include "profiler.h"
+#include "trace.h"
+#include "SDL_bits.h"
+
+#if PROFILER_ENABLED
+
+typedef struct {
+    Uint64 count;
+    Uint64 total;
+    Uint64 min;
+    Uint64 max;
+    Uint32 buckets[PROFILE_BUCKETS];
+} ProfileHistogram;
+
+typedef enum {
+    PROFILE_COPY_IDLE,
+    PROFILE_COPY_REQUESTED,  // The simulation thread fills the copy next
+    PROFILE_COPY_READY       // The render thread reads the copy next
+} ProfileCopyState;
+
+static ProfileHistogram profileHistograms[PROFILE_STAGE_COUNT];
+static ProfileHistogram profileCopy[PROFILE_SIMULATION_STAGES];
+static SDL_atomic_t profileCopyState;  // Hands profileCopy between the two threads
+
+static const char *PROFILE_STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    "tick",
+    "updateLanePositions",
+    "updateVehicle",
+    "updateTrafficLights",
+    "renderRoads",
+    "renderVehicles",
+    "renderHud",
+    "SDL_RenderPresent",
+    "writeCaptureFrame",
+    "writeEventLog"};
+
+// Short names for the HUD font
+static const char *PROFILE_STAGE_LABELS[PROFILE_STAGE_COUNT] = {
+    "TICK",
+    "LANES",
+    "VEHICLE",
+    "LIGHTS",
+    "ROADS",
+    "DRAW",
+    "HUD",
+    "PRESENT",
+    "CAPTURE",
+    "LOG"};
+
+static int profileBucket(Uint64 value)
+{
+    if (value < PROFILE_SUB_BUCKETS)
+        return (int)value;
+
+    int highest = (value >> 32) != 0 ? 32 + SDL_MostSignificantBitIndex32((Uint32)(value >> 32))
+                                     : SDL_MostSignificantBitIndex32((Uint32)value);
+    int shift = highest - PROFILE_SUB_BUCKET_BITS;
+    return (shift + 1) * PROFILE_SUB_BUCKETS + (int)((value >> shift) - PROFILE_SUB_BUCKETS);
+}
+
+static Uint64 profileBucketMidpoint(int bucket)
+{
+    if (bucket < PROFILE_SUB_BUCKETS)
+        return (Uint64)bucket;
+
+    int shift = bucket / PROFILE_SUB_BUCKETS - 1;
+    Uint64 lower = (Uint64)(PROFILE_SUB_BUCKETS + bucket % PROFILE_SUB_BUCKETS) << shift;
+    return lower + ((Uint64)1 << shift) / 2;
+}
+
+void recordProfileSpan(ProfileStage stage, Uint64 start, Uint64 end)
+{
+    Uint64 ticks = end - start;
+    ProfileHistogram *histogram = &profileHistograms[stage];
+    if (histogram->count == 0 || ticks < histogram->min)
+        histogram->min = ticks;
+    if (ticks > histogram->max)
+        histogram->max = ticks;
+    histogram->count++;
+    histogram->total += ticks;
+    histogram->buckets[profileBucket(ticks)]++;
+
+    if (traceActive)
+        recordTraceSpan(stage, start, end);
+}
+
+static void summarizeHistogram(const ProfileHistogram *histogram, ProfileSummary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+    summary->count = histogram->count;
+    if (histogram->count == 0)
+        return;
+
+    // Walk the buckets up to the 99th percentile sample, then report its bucket's midpoint
+    Uint64 target = (histogram->count * 99 + 99) / 100;
+    Uint64 seen = 0;
+    Uint64 p99 = histogram->max;
+    for (int i = 0; i < PROFILE_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= target)
+        {
+            p99 = profileBucketMidpoint(i);
+            break;
+        }
+    }
+    if (p99 < histogram->min)
+        p99 = histogram->min;
+    if (p99 > histogram->max)
+        p99 = histogram->max;
+
+    double microsecondsPerTick = 1e6 / (double)SDL_GetPerformanceFrequency();
+    summary->minMicroseconds = (float)(histogram->min * microsecondsPerTick);
+    summary->meanMicroseconds = (float)((double)histogram->total / histogram->count * microsecondsPerTick);
+    summary->p99Microseconds = (float)(p99 * microsecondsPerTick);
+    summary->maxMicroseconds = (float)(histogram->max * microsecondsPerTick);
+}
+
+void summarizeProfile(ProfileStage stage, ProfileSummary *summary)
+{
+    summarizeHistogram(&profileHistograms[stage], summary);
+}
+
+void requestProfileCopy(void)
+{
+    SDL_AtomicCAS(&profileCopyState, PROFILE_COPY_IDLE, PROFILE_COPY_REQUESTED);
+}
+
+void publishProfileCopy(void)
+{
+    if (SDL_AtomicGet(&profileCopyState) != PROFILE_COPY_REQUESTED)
+        return;
+
+    memcpy(profileCopy, profileHistograms, sizeof(profileCopy));
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&profileCopyState, PROFILE_COPY_READY);
+}
+
+bool summarizeProfileCopy(ProfileSummary *summaries)
+{
+    if (SDL_AtomicGet(&profileCopyState) != PROFILE_COPY_READY)
+        return false;
+
+    SDL_MemoryBarrierAcquire();
+    for (int i = 0; i < PROFILE_SIMULATION_STAGES; i++)
+        summarizeHistogram(&profileCopy[i], &summaries[i]);
+    SDL_AtomicSet(&profileCopyState, PROFILE_COPY_IDLE);
+    return true;
+}
+
+const char *profileStageName(ProfileStage stage)
+{
+    return PROFILE_STAGE_NAMES[stage];
+}
+
+const char *profileStageLabel(ProfileStage stage)
+{
+    return PROFILE_STAGE_LABELS[stage];
+}
+
+void printProfile(void)
+{
+    printf("%-20s %10s %10s %10s %10s %10s\n", "stage (us)", "count", "min", "mean", "p99", "max");
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++)
+    {
+        ProfileSummary summary;
+        summarizeProfile((ProfileStage)i, &summary);
+        if (summary.count == 0)
+            continue;
+        printf("%-20s %10llu %10.2f %10.2f %10.2f %10.2f\n", profileStageName((ProfileStage)i),
+               (unsigned long long)summary.count, summary.minMicroseconds, summary.meanMicroseconds,
+               summary.p99Microseconds, summary.maxMicroseconds);
+    }
+}
+
+#endif
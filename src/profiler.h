@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// Build with -DPROFILER_ENABLED=0 to compile every stage timer out
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#include "perf_counters.h"
+#include "alloc_tracker.h"
+
+#define PROFILE_SUB_BUCKET_BITS 3   // Eight linear sub-buckets per power of two, about 12% resolution
+#define PROFILE_SUB_BUCKETS (1 << PROFILE_SUB_BUCKET_BITS)
+#define PROFILE_BUCKETS (64 * PROFILE_SUB_BUCKETS)
+
+// Simulation stages come first and are timed on the simulation thread, frame
+// stages on the render thread and the I/O stages on the capture and event log
+// writers. Each stage is only ever recorded by one thread.
+typedef enum {
+    PROFILE_TICK,
+    PROFILE_LANE_POSITIONS,
+    PROFILE_VEHICLE_UPDATE,
+    PROFILE_TRAFFIC_LIGHTS,
+    PROFILE_SIMULATION_STAGES,
+    PROFILE_RENDER_ROADS = PROFILE_SIMULATION_STAGES,
+    PROFILE_RENDER_VEHICLES,
+    PROFILE_RENDER_HUD,
+    PROFILE_PRESENT,
+    PROFILE_FRAME_STAGES,
+    PROFILE_CAPTURE_WRITE = PROFILE_FRAME_STAGES,
+    PROFILE_EVENT_LOG_WRITE,
+    PROFILE_STAGE_COUNT
+} ProfileStage;
+
+typedef struct {
+    Uint64 count;
+    float minMicroseconds;
+    float meanMicroseconds;
+    float p99Microseconds;
+    float maxMicroseconds;
+} ProfileSummary;
+
+#if PROFILER_ENABLED
+
+// Scoped stage timers: samples go into a per-stage log-linear histogram of
+// performance counter ticks, so recording is a few integer operations. The
+// span is also kept for the trace file when one is being recorded, and the
+// hardware counters are read outside the stage's own timed span when they are
+// running. A nested stage's reads fall inside its parent's span though, so the
+// tick's time and counters include the reads of the stages within it.
+// Builds that track allocations also charge them to the open stage.
+//
+// PROFILE_BEGIN declares the locals PROFILE_END reads, so it is a statement
+// list rather than one statement: the pair must sit in the same block at the
+// same nesting level, never under an unbraced if or else, and every path out
+// of the block must pass through PROFILE_END.
+#define PROFILE_BEGIN(stage) PERF_BEGIN(stage); ALLOC_BEGIN(stage); Uint64 stage##_start = SDL_GetPerformanceCounter()
+#define PROFILE_END(stage) do { recordProfileSpan(stage, stage##_start, SDL_GetPerformanceCounter()); ALLOC_END(stage); PERF_END(stage); } while (0)
+
+void recordProfileSpan(ProfileStage stage, Uint64 start, Uint64 end);
+void summarizeProfile(ProfileStage stage, ProfileSummary* summary);
+const char* profileStageName(ProfileStage stage);
+const char* profileStageLabel(ProfileStage stage);
+void printProfile(void);
+
+// The HUD summarizes the simulation stages from a copy of their histograms,
+// which the simulation thread takes between ticks when one was requested, so
+// neither thread walks the histograms inside a tick or reads them mid-update.
+void requestProfileCopy(void);
+void publishProfileCopy(void);
+bool summarizeProfileCopy(ProfileSummary* summaries);
+
+#else
+
+#define PROFILE_BEGIN(stage)
+#define PROFILE_END(stage) ((void)0)
+#define printProfile() ((void)0)
+#define publishProfileCopy() ((void)0)
+
+#endif
+
+#endif
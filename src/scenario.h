@@ -0,0 +1,28 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "traffic_simulation.h"
+
+// A fixed workload: the same seed, demand and horizon always produce the
+// same run for a given tick rate and signal controller
+typedef struct {
+    const char* name;
+    const char* description;
+    Uint32 seed;
+    Uint32 duration;         // Simulated milliseconds
+    TrafficDemand demand;
+} Scenario;
+
+int scenarioCount(void);
+const Scenario* getScenario(int index);
+const Scenario* findScenario(const char* name);
+// Seeds the random generator and installs the demand, call before initSimulation
+void applyScenario(const Scenario* scenario);
+// Ticks the scenario's horizon takes at the current tick rate
+int scenarioTicks(const Scenario* scenario);
+void printScenarios(FILE* file);
+
+#endif
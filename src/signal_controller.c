@@ -0,0 +1,225 @@
+#include <string.h>
+#include "signal_controller.h"
+
+typedef struct {
+    const char *name;
+    int (*step)(SignalController *controller, const SignalInput *input);
+    Uint32 (*nextDecision)(const SignalController *controller, const SignalInput *input);
+} SignalControllerOps;
+
+static int lanePhase(int lane)
+{
+    return lane < 2 ? SIGNAL_PHASE_NORTH_SOUTH : SIGNAL_PHASE_EAST_WEST;
+}
+
+static int phaseDemand(const SignalInput *input, int phase)
+{
+    int first = phase == SIGNAL_PHASE_NORTH_SOUTH ? 0 : 2;
+    return input->queueLengths[first] + input->queueLengths[first + 1];
+}
+
+static int switchPhase(SignalController *controller, int phase, Uint32 time)
+{
+    controller->phase = phase;
+    controller->phaseStartTime = time;
+    return SIGNAL_EVENT_PHASE_CHANGE;
+}
+
+static int stepPriority(SignalController *controller, const SignalInput *input)
+{
+    int events = 0;
+
+    // Check for priority conditions (special vehicles or congestion)
+    int priorityLaneCandidate = -1;
+    bool hasSpecialVehicle = false;
+    int maxWaitingVehicles = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (input->emergencyVehicles[i] > 0)
+        {
+            hasSpecialVehicle = true;
+            priorityLaneCandidate = i;
+            break; // Once we find a special vehicle, no need to check other lanes
+        }
+
+        // Track the lane with the longest waiting queue for congestion detection
+        if (input->queueLengths[i] > maxWaitingVehicles)
+        {
+            maxWaitingVehicles = input->queueLengths[i];
+            priorityLaneCandidate = i;
+        }
+    }
+
+    // Determine if we should enter or maintain priority mode
+    if (hasSpecialVehicle || (maxWaitingVehicles > PRIORITY_QUEUE_THRESHOLD && !controller->priorityMode))
+    {
+        // Emergency vehicles renew priority on every tick, only a new priority lane is reported
+        bool renewed = controller->priorityMode && controller->priorityLane == priorityLaneCandidate;
+        controller->priorityMode = true;
+        controller->priorityLane = priorityLaneCandidate;
+        controller->priorityStartTime = input->time;
+        controller->phase = lanePhase(priorityLaneCandidate);
+        controller->phaseStartTime = input->time; // Reset the state change timer
+        if (!renewed)
+            events |= hasSpecialVehicle ? SIGNAL_EVENT_PRIORITY_EMERGENCY : SIGNAL_EVENT_PRIORITY_CONGESTION;
+    }
+    // Exit priority mode after the hold time if no special vehicles remain
+    else if (controller->priorityMode && input->time - controller->priorityStartTime >= PRIORITY_HOLD_TIME)
+    {
+        if (input->emergencyVehicles[controller->priorityLane] == 0)
+        {
+            controller->priorityMode = false;
+            events |= SIGNAL_EVENT_PRIORITY_END;
+        }
+        else
+        {
+            // Extend priority mode
+            controller->priorityStartTime = input->time;
+        }
+    }
+
+    // Normal traffic light cycle if not in priority mode
+    if (!controller->priorityMode && input->time - controller->phaseStartTime >= FIXED_TIME_PHASE_LENGTH)
+    {
+        controller->cyclePhase = 1 - controller->cyclePhase;
+        events |= switchPhase(controller, controller->cyclePhase, input->time);
+    }
+
+    return events;
+}
+
+static Uint32 nextPriorityDecision(const SignalController *controller, const SignalInput *input)
+{
+    // Emergency vehicles renew the priority hold on every tick they are present,
+    // and a congested lane takes priority as soon as none is active
+    for (int i = 0; i < 4; i++)
+    {
+        if (input->emergencyVehicles[i] > 0)
+            return input->time;
+        if (!controller->priorityMode && input->queueLengths[i] > PRIORITY_QUEUE_THRESHOLD)
+            return input->time;
+    }
+
+    if (controller->priorityMode)
+        return controller->priorityStartTime + PRIORITY_HOLD_TIME;
+    return controller->phaseStartTime + FIXED_TIME_PHASE_LENGTH;
+}
+
+static int stepFixedTime(SignalController *controller, const SignalInput *input)
+{
+    if (input->time - controller->phaseStartTime < FIXED_TIME_PHASE_LENGTH)
+        return 0;
+
+    return switchPhase(controller, 1 - controller->phase, input->time);
+}
+
+static Uint32 nextFixedTimeDecision(const SignalController *controller, const SignalInput *input)
+{
+    (void)input;
+    return controller->phaseStartTime + FIXED_TIME_PHASE_LENGTH;
+}
+
+static int stepActuated(SignalController *controller, const SignalInput *input)
+{
+    Uint32 elapsed = input->time - controller->phaseStartTime;
+    if (elapsed < ACTUATED_MIN_GREEN)
+        return 0;
+
+    // Hold the green while its approach still has demand, up to the maximum,
+    // and only give it up when the conflicting approach is waiting
+    int greenDemand = phaseDemand(input, controller->phase);
+    int redDemand = phaseDemand(input, 1 - controller->phase);
+    if (redDemand > 0 && (greenDemand == 0 || elapsed >= ACTUATED_MAX_GREEN))
+        return switchPhase(controller, 1 - controller->phase, input->time);
+
+    return 0;
+}
+
+static Uint32 nextActuatedDecision(const SignalController *controller, const SignalInput *input)
+{
+    Uint32 elapsed = input->time - controller->phaseStartTime;
+    if (elapsed < ACTUATED_MIN_GREEN)
+        return controller->phaseStartTime + ACTUATED_MIN_GREEN;
+
+    // Past the minimum the green only ends when the other approach waits, at
+    // once if its own approach has emptied and otherwise at the maximum
+    if (phaseDemand(input, 1 - controller->phase) == 0)
+        return SIGNAL_WAIT_FOR_INPUT;
+    if (phaseDemand(input, controller->phase) == 0)
+        return input->time;
+    return controller->phaseStartTime + ACTUATED_MAX_GREEN;
+}
+
+static int stepMaxPressure(SignalController *controller, const SignalInput *input)
+{
+    if (input->time - controller->phaseStartTime < MAX_PRESSURE_INTERVAL)
+        return 0;
+
+    // Vehicles leave the network after the intersection, so a phase's pressure
+    // is just its upstream queue. Ties keep the current phase.
+    int current = phaseDemand(input, controller->phase);
+    int other = phaseDemand(input, 1 - controller->phase);
+    if (other > current)
+        return switchPhase(controller, 1 - controller->phase, input->time);
+
+    controller->phaseStartTime = input->time;
+    return 0;
+}
+
+static Uint32 nextMaxPressureDecision(const SignalController *controller, const SignalInput *input)
+{
+    (void)input;
+    return controller->phaseStartTime + MAX_PRESSURE_INTERVAL;
+}
+
+static const SignalControllerOps CONTROLLER_OPS[SIGNAL_CONTROLLER_TYPE_COUNT] = {
+    {"priority", stepPriority, nextPriorityDecision},
+    {"fixed-time", stepFixedTime, nextFixedTimeDecision},
+    {"actuated", stepActuated, nextActuatedDecision},
+    {"max-pressure", stepMaxPressure, nextMaxPressureDecision}};
+
+void initSignalController(SignalController *controller, SignalControllerType type)
+{
+    controller->type = type;
+    resetSignalController(controller);
+}
+
+void resetSignalController(SignalController *controller)
+{
+    // Matches initializeTrafficLights(): East/West starts green
+    controller->phase = SIGNAL_PHASE_EAST_WEST;
+    controller->phaseStartTime = 0;
+    controller->cyclePhase = SIGNAL_PHASE_NORTH_SOUTH;
+    controller->priorityMode = false;
+    controller->priorityLane = -1;
+    controller->priorityStartTime = 0;
+}
+
+int stepSignalController(SignalController *controller, const SignalInput *input)
+{
+    return CONTROLLER_OPS[controller->type].step(controller, input);
+}
+
+Uint32 nextSignalDecision(const SignalController *controller, const SignalInput *input)
+{
+    return CONTROLLER_OPS[controller->type].nextDecision(controller, input);
+}
+
+const char *signalControllerName(SignalControllerType type)
+{
+    return CONTROLLER_OPS[type].name;
+}
+
+bool findSignalController(const char *name, SignalControllerType *type)
+{
+    for (int i = 0; i < SIGNAL_CONTROLLER_TYPE_COUNT; i++)
+    {
+        if (strcmp(CONTROLLER_OPS[i].name, name) == 0)
+        {
+            *type = (SignalControllerType)i;
+            return true;
+        }
+    }
+    return false;
+}
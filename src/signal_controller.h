@@ -0,0 +1,62 @@
+#ifndef SIGNAL_CONTROLLER_H
+#define SIGNAL_CONTROLLER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define SIGNAL_PHASE_NORTH_SOUTH 0  // Lanes 0 and 1 green
+#define SIGNAL_PHASE_EAST_WEST 1    // Lanes 2 and 3 green
+
+#define FIXED_TIME_PHASE_LENGTH 5000   // Milliseconds per phase for the fixed-time cycle
+#define PRIORITY_HOLD_TIME 10000       // Minimum time a priority lane keeps its green
+#define PRIORITY_QUEUE_THRESHOLD 5     // Queued vehicles that make a lane congested
+#define ACTUATED_MIN_GREEN 3000
+#define ACTUATED_MAX_GREEN 15000
+#define MAX_PRESSURE_INTERVAL 2000     // Milliseconds between max-pressure phase decisions
+
+// Events reported by stepSignalController(), combined as bit flags
+#define SIGNAL_EVENT_PHASE_CHANGE 0x1
+#define SIGNAL_EVENT_PRIORITY_EMERGENCY 0x2
+#define SIGNAL_EVENT_PRIORITY_CONGESTION 0x4
+#define SIGNAL_EVENT_PRIORITY_END 0x8
+
+#define SIGNAL_WAIT_FOR_INPUT 0xFFFFFFFFu  // No timed decision pending, only an input change can act
+
+typedef enum {
+    SIGNAL_CONTROLLER_PRIORITY,     // Fixed-time cycle with emergency and congestion overrides
+    SIGNAL_CONTROLLER_FIXED_TIME,
+    SIGNAL_CONTROLLER_ACTUATED,     // Extends green while the green approach has demand
+    SIGNAL_CONTROLLER_MAX_PRESSURE, // Serves the phase with the most queued vehicles
+    SIGNAL_CONTROLLER_TYPE_COUNT
+} SignalControllerType;
+
+// Detector readings for one intersection, gathered by the caller every tick
+typedef struct {
+    Uint32 time;               // Simulated milliseconds
+    int queueLengths[4];       // Stopped vehicles per lane
+    int emergencyVehicles[4];  // Active emergency vehicles per lane
+} SignalInput;
+
+// Complete state of one intersection's controller. It holds no pointers or
+// globals, so any number of intersections can be stepped independently.
+typedef struct {
+    SignalControllerType type;
+    int phase;                 // Phase currently shown, SIGNAL_PHASE_*
+    Uint32 phaseStartTime;
+    int cyclePhase;            // Position in the fixed-time cycle, kept across priority overrides
+    bool priorityMode;
+    int priorityLane;
+    Uint32 priorityStartTime;
+} SignalController;
+
+void initSignalController(SignalController* controller, SignalControllerType type);
+void resetSignalController(SignalController* controller);
+int stepSignalController(SignalController* controller, const SignalInput* input);
+// Earliest time at which stepping again could change anything if the input
+// stays as it is. A time at or before input->time means the next tick. The
+// simulation skips steps before it, so stepping earlier must be a no-op.
+Uint32 nextSignalDecision(const SignalController* controller, const SignalInput* input);
+const char* signalControllerName(SignalControllerType type);
+bool findSignalController(const char* name, SignalControllerType* type);
+
+#endif
@@ -0,0 +1,42 @@
+#include <string.h>
+#include "snapshot_buffer.h"
+
+#define SNAPSHOT_INDEX_MASK 0x3
+#define SNAPSHOT_FRESH 0x4
+
+void initSnapshotBuffer(SnapshotBuffer *buffer)
+{
+    memset(buffer->buffers, 0, sizeof(buffer->buffers));
+    buffer->writeIndex = 0;
+    buffer->readIndex = 1;
+    SDL_AtomicSet(&buffer->published, 2);
+}
+
+SimulationSnapshot *beginSnapshotWrite(SnapshotBuffer *buffer)
+{
+    return &buffer->buffers[buffer->writeIndex];
+}
+
+void publishSnapshot(SnapshotBuffer *buffer)
+{
+    // Swap the freshly written buffer into the middle slot and take back whichever buffer was there.
+    // The snapshot's writes must land before the reader can see its index, and
+    // the reader must be done with the returned buffer before it is rewritten.
+    SDL_MemoryBarrierRelease();
+    int previous = SDL_AtomicSet(&buffer->published, buffer->writeIndex | SNAPSHOT_FRESH);
+    SDL_MemoryBarrierAcquire();
+    buffer->writeIndex = previous & SNAPSHOT_INDEX_MASK;
+}
+
+const SimulationSnapshot *acquireLatestSnapshot(SnapshotBuffer *buffer)
+{
+    // Only swap when the producer has published since our last read, otherwise keep the current buffer
+    if (SDL_AtomicGet(&buffer->published) & SNAPSHOT_FRESH)
+    {
+        SDL_MemoryBarrierRelease();
+        int previous = SDL_AtomicSet(&buffer->published, buffer->readIndex);
+        SDL_MemoryBarrierAcquire();
+        buffer->readIndex = previous & SNAPSHOT_INDEX_MASK;
+    }
+    return &buffer->buffers[buffer->readIndex];
+}
@@ -0,0 +1,22 @@
+#ifndef SNAPSHOT_BUFFER_H
+#define SNAPSHOT_BUFFER_H
+
+#include "traffic_simulation.h"
+
+// Lock-free triple buffer handing simulation snapshots from the simulation
+// thread (single producer) to the render thread (single consumer). The
+// producer never waits for the renderer and the renderer always sees the
+// most recently published tick.
+typedef struct {
+    SimulationSnapshot buffers[3];
+    SDL_atomic_t published;  // Index of the latest published buffer, plus SNAPSHOT_FRESH
+    int writeIndex;          // Owned by the producer
+    int readIndex;           // Owned by the consumer
+} SnapshotBuffer;
+
+void initSnapshotBuffer(SnapshotBuffer* buffer);
+SimulationSnapshot* beginSnapshotWrite(SnapshotBuffer* buffer);
+void publishSnapshot(SnapshotBuffer* buffer);
+const SimulationSnapshot* acquireLatestSnapshot(SnapshotBuffer* buffer);
+
+#endif
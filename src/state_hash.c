@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "state_hash.h"
+
+#define HASH_OFFSET_BASIS 0xcbf29ce484222325ull  // 64-bit FNV-1a, applied to whole words
+#define HASH_PRIME 0x100000001b3ull
+
+static Uint64 hashWord(Uint64 hash, Uint32 word)
+{
+    return (hash ^ word) * HASH_PRIME;
+}
+
+static Uint64 hashFloat(Uint64 hash, float value)
+{
+    Uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hashWord(hash, bits);
+}
+
+Uint64 hashVehicle(const Vehicle *vehicle)
+{
+    Uint64 hash = HASH_OFFSET_BASIS;
+    hash = hashWord(hash, (Uint32)vehicle->type);
+    hash = hashWord(hash, (Uint32)vehicle->direction);
+    hash = hashWord(hash, (Uint32)vehicle->turnDirection);
+    hash = hashWord(hash, (Uint32)vehicle->state);
+    hash = hashWord(hash, (Uint32)vehicle->active | (Uint32)vehicle->isInRightLane << 1 |
+                              (Uint32)vehicle->turnProgress << 2 | (Uint32)vehicle->canSkipLight << 3);
+    hash = hashFloat(hash, vehicle->speed);
+    hash = hashFloat(hash, vehicle->x);
+    hash = hashFloat(hash, vehicle->y);
+    hash = hashFloat(hash, vehicle->turnAngle);
+    hash = hashFloat(hash, vehicle->prevX);
+    hash = hashFloat(hash, vehicle->prevY);
+    hash = hashFloat(hash, vehicle->prevTurnAngle);
+    hash = hashWord(hash, (Uint32)vehicle->rect.x);
+    hash = hashWord(hash, (Uint32)vehicle->rect.y);
+    hash = hashWord(hash, (Uint32)vehicle->rect.w);
+    hash = hashWord(hash, (Uint32)vehicle->rect.h);
+    hash = hashWord(hash, (Uint32)vehicle->lane);
+    hash = hashWord(hash, (Uint32)vehicle->queueLane);
+    return hash;
+}
+
+static Uint64 hashTimer(Uint64 hash, const Simulation *sim, int handle)
+{
+    // By expiry rather than handle, the pool slot a timer landed in is not state
+    return hashWord(hash, handle >= 0 ? sim->timerPool[handle].expiry : 0xFFFFFFFFu);
+}
+
+Uint64 hashSimulationState(const Simulation *sim)
+{
+    // Everything a later tick reads: the vehicles, the lane queues and counts
+    // kept beside them, the clock, the random stream, the statistics, the
+    // spawner, the signal controller and the pending timers
+    Uint64 hash = HASH_OFFSET_BASIS;
+    hash = hashWord(hash, sim->tick);
+    hash = hashWord(hash, sim->time);
+    hash = hashWord(hash, sim->random);
+    hash = hashWord(hash, (Uint32)sim->vehicleCount);
+
+    // Only occupied slots, each tied to its index
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        if (!sim->vehicles[i].active)
+            continue;
+        Uint64 vehicle = hashVehicle(&sim->vehicles[i]);
+        hash = hashWord(hash, (Uint32)i);
+        hash = hashWord(hash, (Uint32)vehicle);
+        hash = hashWord(hash, (Uint32)(vehicle >> 32));
+    }
+
+    // Queues in order, discharge order and wait times depend on it
+    for (int i = 0; i < 4; i++)
+    {
+        hash = hashWord(hash, (Uint32)sim->laneQueues[i].size);
+        for (const Node *node = sim->laneQueues[i].front; node != NULL; node = node->next)
+        {
+            hash = hashWord(hash, (Uint32)node->entry.vehicle);
+            hash = hashWord(hash, node->entry.enqueueTime);
+        }
+        hash = hashWord(hash, (Uint32)sim->emergencyVehiclesInLane[i]);
+    }
+
+    hash = hashWord(hash, (Uint32)sim->stats.vehiclesPassed);
+    hash = hashWord(hash, (Uint32)sim->stats.totalVehicles);
+    hash = hashFloat(hash, sim->stats.vehiclesPerMinute);
+    hash = hashWord(hash, sim->stats.startTime);
+    hash = hashWord(hash, sim->stats.totalWaitTime);
+    hash = hashWord(hash, (Uint32)sim->stats.vehiclesDischarged);
+
+    hash = hashWord(hash, sim->lastVehicleSpawn);
+    hash = hashWord(hash, (Uint32)sim->spawnPending);
+    hash = hashTimer(hash, sim, sim->spawnTimer);
+
+    for (int i = 0; i < 4; i++)
+    {
+        hash = hashWord(hash, (Uint32)sim->lights[i].state);
+        hash = hashWord(hash, (Uint32)sim->lights[i].timer);
+    }
+    const SignalController *controller = &sim->controller;
+    hash = hashWord(hash, (Uint32)controller->type);
+    hash = hashWord(hash, (Uint32)controller->phase);
+    hash = hashWord(hash, controller->phaseStartTime);
+    hash = hashWord(hash, (Uint32)controller->cyclePhase);
+    hash = hashWord(hash, (Uint32)controller->priorityMode | (Uint32)controller->priorityLane << 1);
+    hash = hashWord(hash, controller->priorityStartTime);
+    hash = hashWord(hash, sim->signalDecision);
+    hash = hashWord(hash, (Uint32)sim->signalDue);
+    hash = hashTimer(hash, sim, sim->signalTimer);
+    return hash;
+}
+
+static void printVehicle(const char *label, const Vehicle *vehicle)
+{
+    printf("  %-10s active %d type %d direction %d turn %d state %d lane %d queue %d skip %d\n", label,
+           vehicle->active, vehicle->type, vehicle->direction, vehicle->turnDirection, vehicle->state,
+           vehicle->lane, vehicle->queueLane, vehicle->canSkipLight);
+    printf("  %-10s x %.9g y %.9g speed %.9g angle %.9g prev %.9g %.9g %.9g\n", "",
+           vehicle->x, vehicle->y, vehicle->speed, vehicle->turnAngle, vehicle->prevX, vehicle->prevY, vehicle->prevTurnAngle);
+}
+
+static void printSimulationState(const char *label, const Simulation *sim)
+{
+    const SignalController *controller = &sim->controller;
+    printf("  %-10s vehicles %d lights %d%d%d%d phase %d since %u cycle %d priority %d lane %d since %u decision %u\n", label,
+           sim->vehicleCount, sim->lights[0].state, sim->lights[1].state, sim->lights[2].state, sim->lights[3].state,
+           controller->phase, controller->phaseStartTime, controller->cyclePhase, controller->priorityMode,
+           controller->priorityLane, controller->priorityStartTime, sim->signalDecision);
+    printf("  %-10s passed %d spawned %d discharged %d wait %u last spawn %u pending %d\n", "",
+           sim->stats.vehiclesPassed, sim->stats.totalVehicles, sim->stats.vehiclesDischarged, sim->stats.totalWaitTime,
+           sim->lastVehicleSpawn, sim->spawnPending);
+    printf("  %-10s time %u random %08x queued %d %d %d %d emergency %d %d %d %d\n", "",
+           sim->time, sim->random, sim->laneQueues[0].size, sim->laneQueues[1].size, sim->laneQueues[2].size,
+           sim->laneQueues[3].size, sim->emergencyVehiclesInLane[0], sim->emergencyVehiclesInLane[1],
+           sim->emergencyVehiclesInLane[2], sim->emergencyVehiclesInLane[3]);
+}
+
+// Both simulations have run the divergent tick, point at what differs
+static void reportDivergence(const Simulation *reference, const Simulation *candidate, const char *name)
+{
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        bool referenceActive = reference->vehicles[i].active;
+        bool candidateActive = candidate->vehicles[i].active;
+        if (!referenceActive && !candidateActive)
+            continue;
+        if (referenceActive == candidateActive && hashVehicle(&reference->vehicles[i]) == hashVehicle(&candidate->vehicles[i]))
+            continue;
+
+        printf("First divergent vehicle: slot %d\n", i);
+        printVehicle("reference", &reference->vehicles[i]);
+        printVehicle(name, &candidate->vehicles[i]);
+        return;
+    }
+
+    // Vehicles agree, so it is the state kept beside them
+    printf("Vehicles match, the rest of the state differs\n");
+    printSimulationState("reference", reference);
+    printSimulationState(name, candidate);
+}
+
+bool verifySimulationEngine(const SimulationEngine *engine, Uint32 seed, int ticks)
+{
+    // Each simulation carries its own clock, queues and random stream, so the
+    // two start from the same seed and step side by side up to the first mismatch
+    static Simulation reference;
+    static Simulation candidate;
+    const SimulationEngine *referenceEngine = findSimulationEngine("reference");
+
+    if (ticks <= 0)
+    {
+        fprintf(stderr, "Nothing to verify in %d ticks\n", ticks);
+        return false;
+    }
+
+    srand(seed);
+    initSimulation(&reference);
+    srand(seed);
+    initSimulation(&candidate);
+
+    Uint64 expected = 0;
+    Uint64 actual = 0;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        referenceEngine->step(&reference);
+        engine->step(&candidate);
+        expected = hashSimulationState(&reference);
+        actual = hashSimulationState(&candidate);
+        if (actual != expected)
+        {
+            printf("Engine %s diverges from the reference at tick %u of %d (seed %u): state %016llx, expected %016llx\n",
+                   engine->name, candidate.tick, ticks, seed, (unsigned long long)actual, (unsigned long long)expected);
+            reportDivergence(&reference, &candidate, engine->name);
+            return false;
+        }
+    }
+
+    if (engine == referenceEngine)
+        printf("Engine reference was checked against itself, which only shows the run is deterministic\n");
+    printf("Engine %s matches the reference for %d ticks (seed %u, final state %016llx)\n",
+           engine->name, ticks, seed, (unsigned long long)expected);
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "traffic_simulation.h"
+
+// 64-bit hashes of simulation state, built field by field so padding and the
+// stale contents of free vehicle slots never take part. The simulation hash
+// covers all of the state a later tick reads, the lane queues and random stream included. Floats are hashed
+// by their bits: an engine only matches if it computes exactly the same values.
+Uint64 hashVehicle(const Vehicle* vehicle);
+Uint64 hashSimulationState(const Simulation* sim);
+
+// Steps a reference simulation and one run by the given engine side by side
+// from the same seed for the given number of ticks, comparing the state hash
+// after every tick. Prints the first divergent tick and vehicle, returns
+// whether the engines matched. Checking the reference against itself only
+// shows that a run is deterministic.
+bool verifySimulationEngine(const SimulationEngine* engine, Uint32 seed, int ticks);
+
+#endif
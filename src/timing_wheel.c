@@ -0,0 +1,147 @@
+#include "timing_wheel.h"
+
+static void linkTimer(TimingWheel *wheel, int handle, int list)
+{
+    Timer *timer = &wheel->timers[handle];
+    timer->list = list;
+    timer->prev = -1;
+    timer->next = wheel->lists[list];
+    if (timer->next >= 0)
+        wheel->timers[timer->next].prev = handle;
+    wheel->lists[list] = handle;
+}
+
+static void unlinkTimer(TimingWheel *wheel, int handle)
+{
+    Timer *timer = &wheel->timers[handle];
+    if (timer->prev >= 0)
+        wheel->timers[timer->prev].next = timer->next;
+    else
+        wheel->lists[timer->list] = timer->next;
+    if (timer->next >= 0)
+        wheel->timers[timer->next].prev = timer->prev;
+    timer->list = -1;
+}
+
+static void fileTimer(TimingWheel *wheel, int handle)
+{
+    Uint32 expiry = wheel->timers[handle].expiry;
+    if ((Sint32)(expiry - wheel->now) < 0)
+    {
+        linkTimer(wheel, handle, TIMING_WHEEL_EXPIRED);
+        return;
+    }
+
+    // Pick the lowest level whose span reaches the expiry, beyond the top
+    // level park the timer in the furthest slot to be re-filed from there
+    Uint32 delta = expiry - wheel->now;
+    int level = 0;
+    while (level < TIMING_WHEEL_LEVELS - 1 && delta >= (1u << (TIMING_WHEEL_BITS * (level + 1))))
+    {
+        level++;
+    }
+    if (level == TIMING_WHEEL_LEVELS - 1 && delta >= (1u << (TIMING_WHEEL_BITS * TIMING_WHEEL_LEVELS)))
+    {
+        expiry = wheel->now + (1u << (TIMING_WHEEL_BITS * TIMING_WHEEL_LEVELS)) - 1;
+    }
+
+    int slot = (expiry >> (TIMING_WHEEL_BITS * level)) & (TIMING_WHEEL_SLOTS - 1);
+    linkTimer(wheel, handle, level * TIMING_WHEEL_SLOTS + slot);
+}
+
+static int cascade(TimingWheel *wheel, int level)
+{
+    // Re-file every timer in the level's current slot into the levels below
+    int slot = (wheel->now >> (TIMING_WHEEL_BITS * level)) & (TIMING_WHEEL_SLOTS - 1);
+    int list = level * TIMING_WHEEL_SLOTS + slot;
+    int handle = wheel->lists[list];
+    wheel->lists[list] = -1;
+
+    while (handle >= 0)
+    {
+        int next = wheel->timers[handle].next;
+        fileTimer(wheel, handle);
+        handle = next;
+    }
+    return slot;
+}
+
+void initTimingWheel(TimingWheel *wheel, Timer *timers, int capacity, Uint32 now)
+{
+    wheel->timers = timers;
+    wheel->capacity = capacity;
+    wheel->now = now;
+    for (int i = 0; i < TIMING_WHEEL_LISTS; i++)
+    {
+        wheel->lists[i] = -1;
+    }
+
+    wheel->freeList = capacity > 0 ? 0 : -1;
+    for (int i = 0; i < capacity; i++)
+    {
+        timers[i].next = i + 1 < capacity ? i + 1 : -1;
+        timers[i].list = -1;
+    }
+}
+
+int scheduleTimer(TimingWheel *wheel, Uint32 expiry, int type, int target)
+{
+    int handle = wheel->freeList;
+    if (handle < 0)
+        return -1;
+
+    Timer *timer = &wheel->timers[handle];
+    wheel->freeList = timer->next;
+    timer->expiry = expiry;
+    timer->type = type;
+    timer->target = target;
+    fileTimer(wheel, handle);
+    return handle;
+}
+
+void cancelTimer(TimingWheel *wheel, int handle)
+{
+    if (handle < 0 || wheel->timers[handle].list < 0)
+        return;
+
+    unlinkTimer(wheel, handle);
+    wheel->timers[handle].next = wheel->freeList;
+    wheel->freeList = handle;
+}
+
+void advanceTimingWheel(TimingWheel *wheel, Uint32 tick)
+{
+    while ((Sint32)(tick - wheel->now) >= 0)
+    {
+        // Entering a new lap of a level pulls the next slot of the level above down
+        for (int level = 1; level < TIMING_WHEEL_LEVELS; level++)
+        {
+            if ((wheel->now & ((1u << (TIMING_WHEEL_BITS * level)) - 1)) != 0 || cascade(wheel, level) != 0)
+                break;
+        }
+
+        // Everything in the current bottom slot expires on this tick
+        int list = wheel->now & (TIMING_WHEEL_SLOTS - 1);
+        int handle = wheel->lists[list];
+        wheel->lists[list] = -1;
+        while (handle >= 0)
+        {
+            int next = wheel->timers[handle].next;
+            linkTimer(wheel, handle, TIMING_WHEEL_EXPIRED);
+            handle = next;
+        }
+
+        wheel->now++;
+    }
+}
+
+bool popExpiredTimer(TimingWheel *wheel, Timer *fired)
+{
+    int handle = wheel->lists[TIMING_WHEEL_EXPIRED];
+    if (handle < 0)
+        return false;
+
+    *fired = wheel->timers[handle];
+    cancelTimer(wheel, handle);
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define TIMING_WHEEL_BITS 6
+#define TIMING_WHEEL_SLOTS (1 << TIMING_WHEEL_BITS)
+#define TIMING_WHEEL_LEVELS 4   // Covers 2^24 ticks ahead, later timers are re-filed as the wheel turns
+#define TIMING_WHEEL_LISTS (TIMING_WHEEL_LEVELS * TIMING_WHEEL_SLOTS + 1)
+#define TIMING_WHEEL_EXPIRED (TIMING_WHEEL_LISTS - 1)
+
+typedef struct {
+    Uint32 expiry;   // Tick the timer fires on
+    int type;        // Caller-defined event type
+    int target;      // Caller-defined subject, e.g. an intersection index
+    int next;        // Links within the slot list, -1 terminated
+    int prev;
+    int list;        // Slot list holding the timer, -1 when free
+} Timer;
+
+// Hierarchical timing wheel keyed on simulation ticks. Each level has 64
+// slots covering 64 times the span of the level below; timers are filed by
+// expiry and only move down a level when the wheel reaches their slot, so
+// advancing one tick costs time proportional to the timers that fire rather
+// than to the number scheduled. Timers live in a caller-provided pool and are
+// addressed by index.
+typedef struct {
+    Timer* timers;
+    int capacity;
+    int freeList;
+    int lists[TIMING_WHEEL_LISTS];  // Head of each slot list, then the expired list
+    Uint32 now;                     // Next tick to process
+} TimingWheel;
+
+void initTimingWheel(TimingWheel* wheel, Timer* timers, int capacity, Uint32 now);
+int scheduleTimer(TimingWheel* wheel, Uint32 expiry, int type, int target);
+void cancelTimer(TimingWheel* wheel, int handle);
+void advanceTimingWheel(TimingWheel* wheel, Uint32 tick);
+bool popExpiredTimer(TimingWheel* wheel, Timer* fired);
+
+#endif
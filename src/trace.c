@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "trace.h"
+
+#if PROFILER_ENABLED
+
+typedef struct {
+    TraceEvent events[TRACE_EVENTS_PER_THREAD];
+    int count;
+    Uint32 dropped;
+    const char *name;
+} TraceBuffer;
+
+bool traceActive = false;  // Only changed while no other thread is recording
+
+static FILE *traceFile = NULL;
+static char tracePath[260];
+static Uint64 traceStart = 0;
+static SDL_TLSID traceBufferKey = 0;
+static SDL_atomic_t traceBufferCount;
+static void *traceBuffers[TRACE_MAX_THREADS];
+static SDL_atomic_t traceUnregistered;  // Spans lost because every buffer was taken
+
+// Threads are named after the kind of stage they record first
+static const char *traceThreadName(ProfileStage stage)
+{
+    if (stage < PROFILE_SIMULATION_STAGES)
+        return "simulation";
+    if (stage < PROFILE_FRAME_STAGES)
+        return "render";
+    if (stage == PROFILE_CAPTURE_WRITE)
+        return "frame capture";
+    return "event log";
+}
+
+static TraceBuffer *registerTraceBuffer(ProfileStage stage)
+{
+    int index = SDL_AtomicAdd(&traceBufferCount, 1);
+    if (index >= TRACE_MAX_THREADS)
+        return NULL;
+
+    // Allocated once per recording thread, the first span pays for it
+    TraceBuffer *buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
+    if (buffer == NULL)
+        return NULL;
+    buffer->count = 0;
+    buffer->dropped = 0;
+    buffer->name = traceThreadName(stage);
+    SDL_TLSSet(traceBufferKey, buffer, NULL);
+    SDL_AtomicSetPtr(&traceBuffers[index], buffer);
+    return buffer;
+}
+
+bool startTrace(const char *path)
+{
+    // Opened up front so a bad path is reported before the run, not after it
+    traceFile = fopen(path, "w");
+    if (traceFile == NULL)
+    {
+        perror("Failed to open trace");
+        return false;
+    }
+    SDL_strlcpy(tracePath, path, sizeof(tracePath));
+
+    traceBufferKey = SDL_TLSCreate();
+    if (traceBufferKey == 0)
+    {
+        fprintf(stderr, "Failed to start trace: %s\n", SDL_GetError());
+        fclose(traceFile);
+        traceFile = NULL;
+        return false;
+    }
+    SDL_AtomicSet(&traceBufferCount, 0);
+    SDL_AtomicSet(&traceUnregistered, 0);
+    traceStart = SDL_GetPerformanceCounter();
+    traceActive = true;
+    return true;
+}
+
+void stopTrace(void)
+{
+    if (!traceActive)
+        return;
+
+    // Called once every recording thread has finished
+    traceActive = false;
+
+    double microsecondsPerTick = 1e6 / (double)SDL_GetPerformanceFrequency();
+    Uint32 written = 0;
+    Uint32 dropped = (Uint32)SDL_AtomicGet(&traceUnregistered);
+    const char *separator = "";
+
+    fprintf(traceFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int count = SDL_AtomicGet(&traceBufferCount);
+    for (int i = 0; i < count && i < TRACE_MAX_THREADS; i++)
+    {
+        TraceBuffer *buffer = (TraceBuffer *)SDL_AtomicGetPtr(&traceBuffers[i]);
+        if (buffer == NULL)
+            continue;
+
+        // Thread ids are buffer indices, the metadata event gives each one a name
+        int thread = i + 1;
+        fprintf(traceFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                separator, thread, buffer->name);
+        separator = ",\n";
+
+        for (int j = 0; j < buffer->count; j++)
+        {
+            const TraceEvent *event = &buffer->events[j];
+            fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    profileStageName((ProfileStage)event->stage), thread,
+                    (double)(event->start - traceStart) * microsecondsPerTick, (double)event->duration * microsecondsPerTick);
+        }
+        written += buffer->count;
+        dropped += buffer->dropped;
+
+        free(buffer);
+        SDL_AtomicSetPtr(&traceBuffers[i], NULL);
+    }
+    fprintf(traceFile, "\n]}\n");
+    fclose(traceFile);
+    traceFile = NULL;
+
+    printf("Trace %s: %u spans written, %u dropped\n", tracePath, written, dropped);
+}
+
+void recordTraceSpan(ProfileStage stage, Uint64 start, Uint64 end)
+{
+    TraceBuffer *buffer = (TraceBuffer *)SDL_TLSGet(traceBufferKey);
+    if (buffer == NULL && (buffer = registerTraceBuffer(stage)) == NULL)
+    {
+        SDL_AtomicAdd(&traceUnregistered, 1);
+        return;
+    }
+
+    if (buffer->count == TRACE_EVENTS_PER_THREAD)
+    {
+        buffer->dropped++;
+        return;
+    }
+
+    TraceEvent *event = &buffer->events[buffer->count++];
+    event->start = start;
+    event->duration = end - start;
+    event->stage = stage;
+}
+
+#endif
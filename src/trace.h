@@ -0,0 +1,36 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "profiler.h"
+
+#define TRACE_EVENTS_PER_THREAD 262144  // Spans buffered per thread before new ones are dropped
+#define TRACE_MAX_THREADS 16
+
+// One finished span, kept in memory until the trace is written
+typedef struct {
+    Uint64 start;          // Performance counter ticks
+    Uint64 duration;
+    int stage;             // ProfileStage
+} TraceEvent;
+
+#if PROFILER_ENABLED
+
+// Every profiled stage span is also appended to a per-thread buffer while a
+// trace is running. Nothing is formatted or written until stopTrace, which
+// saves the spans as Chrome trace-event JSON for chrome://tracing or Perfetto.
+bool startTrace(const char* path);
+void stopTrace(void);
+void recordTraceSpan(ProfileStage stage, Uint64 start, Uint64 end);
+
+extern bool traceActive;
+
+#else
+
+#define startTrace(path) ((void)(path), true)
+#define stopTrace() ((void)0)
+
+#endif
+
+#endif
@@ -1,15 +1,24 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "traffic_simulation.h"
+#include "heatmap.h"
+#include "event_log.h"
 
-// Global queues for lanes
-Queue laneQueues[4];
 int lanePriorities[4] = {0};
-LanePosition laneVehicles[4][MAX_VEHICLES];
-int vehiclesInLane[4] = {0};
 
-const SDL_Color VEHICLE_COLORS[] = {
+// Controller installed on new simulations
+SignalControllerType simulationControllerType = SIGNAL_CONTROLLER_PRIORITY;
+
+// Spawn rate and vehicle mix, scenarios replace it
+TrafficDemand simulationDemand = {SPAWN_INTERVAL, EMERGENCY_PERCENT, TURN_PERCENT};
+
+// Tick rate the simulation thread runs at, and how many reference ticks each tick covers
+int simulationTickRate = SIM_TICK_RATE;
+float simulationStepScale = 1.0f;
+
+const SDL_Color VEHICLE_COLORS[VEHICLE_TYPE_COUNT] = {
     {0, 0, 255, 255}, // REGULAR_CAR: Blue
     {255, 0, 0, 255}, // AMBULANCE: Red
     {0, 0, 128, 255}, // POLICE_CAR: Dark Blue
@@ -23,6 +32,31 @@ float getDistanceBetweenVehicles(Vehicle *v1, Vehicle *v2)
     return sqrt(dx * dx + dy * dy);
 }
 
+bool isEmergencyVehicle(const Vehicle *vehicle)
+{
+    return vehicle->type == AMBULANCE || vehicle->type == POLICE_CAR || vehicle->type == FIRE_TRUCK;
+}
+
+bool trackVehicleLane(Simulation *sim, Vehicle *vehicle)
+{
+    // Keep per-lane emergency counts current on spawn, lane change and despawn,
+    // returns whether the counts changed
+    int lane = vehicle->active ? getVehicleLane(vehicle) : -1;
+    if (lane == vehicle->lane)
+        return false;
+
+    int previous = vehicle->lane;
+    vehicle->lane = lane;
+    if (!isEmergencyVehicle(vehicle))
+        return false;
+
+    if (previous >= 0)
+        sim->emergencyVehiclesInLane[previous]--;
+    if (lane >= 0)
+        sim->emergencyVehiclesInLane[lane]++;
+    return true;
+}
+
 int getVehicleLane(Vehicle *vehicle)
 {
     if (vehicle->direction == DIRECTION_NORTH || vehicle->direction == DIRECTION_SOUTH)
@@ -59,161 +93,121 @@ void initializeTrafficLights(TrafficLight *lights)
         .direction = DIRECTION_WEST};
 }
 
-void updateTrafficLights(TrafficLight *lights)
+void applySignalPhase(TrafficLight *lights, int phase)
 {
-    static Uint32 lastStateChangeTicks = 0;
-    static int currentPhase = 0;
-    static bool priorityMode = false;
-    static int priorityLane = -1;
-    static Uint32 priorityStartTime = 0;
-    Uint32 currentTicks = SDL_GetTicks();
+    TrafficLightState northSouth = phase == SIGNAL_PHASE_NORTH_SOUTH ? GREEN : RED;
+    TrafficLightState eastWest = phase == SIGNAL_PHASE_NORTH_SOUTH ? RED : GREEN;
+    lights[DIRECTION_NORTH].state = northSouth;
+    lights[DIRECTION_SOUTH].state = northSouth;
+    lights[DIRECTION_EAST].state = eastWest;
+    lights[DIRECTION_WEST].state = eastWest;
+}
 
-    // Check for priority conditions (special vehicles or congestion)
-    int priorityLaneCandidate = -1;
-    bool hasSpecialVehicle = false;
-    int maxWaitingVehicles = 0;
+// A simulation has at most one spawn timer and one signal decision timer pending
+SDL_COMPILE_TIME_ASSERT(simulationTimers, SIMULATION_TIMERS >= 2);
 
-    // First pass: check for special vehicles in each lane
+static int scheduleSimulationTimer(Simulation *sim, Uint32 expiryTick, int type)
+{
+    // Each timer is consumed or cancelled before its type is scheduled again,
+    // so the pool cannot run out
+    int handle = scheduleTimer(&sim->timers, expiryTick, type, 0);
+    SDL_assert(handle >= 0);
+    return handle;
+}
+
+static void gatherSignalInput(const Simulation *sim, SignalInput *input)
+{
+    input->time = sim->time;
     for (int i = 0; i < 4; i++)
     {
-        for (int j = 0; j < vehiclesInLane[i]; j++)
-        {
-            Vehicle *vehicle = laneVehicles[i][j].vehicle;
-            if (vehicle && (vehicle->type == AMBULANCE || vehicle->type == POLICE_CAR || vehicle->type == FIRE_TRUCK))
-            {
-                hasSpecialVehicle = true;
-                priorityLaneCandidate = i;
-                // Allow emergency vehicles to pass red lights
-                vehicle->canSkipLight = true;
-                break;
-            }
-        }
-        if (hasSpecialVehicle)
-            break; // Once we find a special vehicle, no need to check other lanes
-
-        // Track the lane with the most vehicles for congestion detection
-        if (vehiclesInLane[i] > maxWaitingVehicles)
-        {
-            maxWaitingVehicles = vehiclesInLane[i];
-            priorityLaneCandidate = i;
-        }
+        input->queueLengths[i] = sim->laneQueues[i].size;
+        input->emergencyVehicles[i] = sim->emergencyVehiclesInLane[i];
     }
+}
 
-    // Determine if we should enter or maintain priority mode
-    if (hasSpecialVehicle || (maxWaitingVehicles > 5 && !priorityMode))
-    {
-        priorityMode = true;
-        priorityLane = priorityLaneCandidate;
-        priorityStartTime = currentTicks;
-
-        // Fix: explicitly set lights based on direction rather than using modulo
-        // This ensures correct pairing of traffic lights
-        if (priorityLane == 0 || priorityLane == 1)
-        { // North or South lane has priority
-            // Give green to North-South, red to East-West
-            lights[DIRECTION_NORTH].state = GREEN;
-            lights[DIRECTION_SOUTH].state = GREEN;
-            lights[DIRECTION_EAST].state = RED;
-            lights[DIRECTION_WEST].state = RED;
-        }
-        else
-        { // East or West lane has priority
-            // Give green to East-West, red to North-South
-            lights[DIRECTION_NORTH].state = RED;
-            lights[DIRECTION_SOUTH].state = RED;
-            lights[DIRECTION_EAST].state = GREEN;
-            lights[DIRECTION_WEST].state = GREEN;
-        }
+static void scheduleSignalDecision(Simulation *sim, Uint32 decision, Uint32 time)
+{
+    // Sleep until the controller's next timed decision, the timer is only
+    // moved when the decision did
+    if (decision == sim->signalDecision && decision > time && sim->signalTimer >= 0)
+        return;
 
-        printf("Priority mode activated at %d ms. Lane %d prioritized. Reason: %s\n",
-               currentTicks, priorityLane, hasSpecialVehicle ? "Emergency Vehicle" : "Congestion");
-        lastStateChangeTicks = currentTicks; // Reset the state change timer
-    }
-    // Exit priority mode after 10 seconds if no special vehicles remain
-    else if (priorityMode && currentTicks - priorityStartTime >= 10000)
+    cancelTimer(&sim->timers, sim->signalTimer);
+    sim->signalTimer = -1;
+    sim->signalDecision = decision;
+    if (decision != SIGNAL_WAIT_FOR_INPUT)
     {
-        bool stillHasSpecialVehicle = false;
+        Uint32 decisionTick = decision > time ? simulationTickAt(decision) : sim->tick + 1;
+        sim->signalTimer = scheduleSimulationTimer(sim, decisionTick, TIMER_SIGNAL_DECISION);
+    }
+}
 
-        // Check if special vehicles are still present in the priority lane
-        for (int j = 0; j < vehiclesInLane[priorityLane]; j++)
-        {
-            Vehicle *vehicle = laneVehicles[priorityLane][j].vehicle;
-            if (vehicle && (vehicle->type == AMBULANCE || vehicle->type == POLICE_CAR || vehicle->type == FIRE_TRUCK))
-            {
-                stillHasSpecialVehicle = true;
-                break;
-            }
-        }
+static void checkSignalInput(Simulation *sim)
+{
+    // Stepping before the next decision changes nothing, so an input change
+    // only wakes the controller when it brings that decision forward to now.
+    // Otherwise it may still have moved it, e.g. demand arriving on red.
+    SignalInput input;
+    gatherSignalInput(sim, &input);
+    Uint32 decision = nextSignalDecision(&sim->controller, &input);
+    if (decision != SIGNAL_WAIT_FOR_INPUT && decision <= input.time)
+        sim->signalDue = true;
+    else
+        scheduleSignalDecision(sim, decision, input.time);
+}
 
-        if (!stillHasSpecialVehicle)
-        {
-            priorityMode = false;
-            printf("Priority mode deactivated at %d ms. Returning to normal cycle.\n", currentTicks);
-        }
-        else
-        {
-            // Extend priority mode
-            priorityStartTime = currentTicks;
-        }
-    }
+void updateTrafficLights(Simulation *sim)
+{
+    SignalInput input;
+    gatherSignalInput(sim, &input);
 
-    // Normal traffic light cycle if not in priority mode
-    if (!priorityMode && currentTicks - lastStateChangeTicks >= 5000)
-    {
-        // Toggle between phases (0 = N/S green, E/W red; 1 = N/S red, E/W green)
-        currentPhase = 1 - currentPhase;
+    SignalController *controller = &sim->controller;
+    int events = stepSignalController(controller, &input);
+    sim->signalDue = false;
+    scheduleSignalDecision(sim, nextSignalDecision(controller, &input), input.time);
 
-        if (currentPhase == 0)
-        { // North/South green, East/West red
-            lights[DIRECTION_NORTH].state = GREEN;
-            lights[DIRECTION_SOUTH].state = GREEN;
-            lights[DIRECTION_EAST].state = RED;
-            lights[DIRECTION_WEST].state = RED;
-        }
-        else
-        { // North/South red, East/West green
-            lights[DIRECTION_NORTH].state = RED;
-            lights[DIRECTION_SOUTH].state = RED;
-            lights[DIRECTION_EAST].state = GREEN;
-            lights[DIRECTION_WEST].state = GREEN;
-        }
+    if (events == 0)
+        return;
 
-        lastStateChangeTicks = currentTicks;
-        printf("State changed at %d ms. Phase: %d, Reason: Normal Cycle\n", currentTicks, currentPhase);
+    applySignalPhase(sim->lights, controller->phase);
+
+    // Binary records for the background writer, decode with event_log_decode
+    if (events & (SIGNAL_EVENT_PRIORITY_EMERGENCY | SIGNAL_EVENT_PRIORITY_CONGESTION))
+    {
+        LOG_EVENT(EVENT_PRIORITY_START, sim->tick, input.time, 0, controller->priorityLane,
+                  (events & SIGNAL_EVENT_PRIORITY_EMERGENCY) ? EVENT_REASON_EMERGENCY : EVENT_REASON_CONGESTION,
+                  controller->phase, controller->type);
+    }
+    if (events & SIGNAL_EVENT_PRIORITY_END)
+    {
+        LOG_EVENT(EVENT_PRIORITY_END, sim->tick, input.time, 0, controller->priorityLane, EVENT_REASON_CLEARED,
+                  controller->phase, controller->type);
     }
+    if (events & SIGNAL_EVENT_PHASE_CHANGE)
+    {
+        LOG_EVENT(EVENT_PHASE_CHANGE, sim->tick, input.time, 0, -1, EVENT_REASON_CYCLE, controller->phase, controller->type);
+    }
+}
 
-    // Reset canSkipLight flag for non-emergency vehicles
-    // for (int i = 0; i < 4; i++)
-    // {
-    //     for (int j = 0; j < vehiclesInLane[i]; j++)
-    //     {
-    //         Vehicle *vehicle = laneVehicles[i][j].vehicle;
-    //         if (vehicle && vehicle->type == REGULAR_CAR)
-    //         {
-    //             vehicle->canSkipLight = false;
-    //         }
-    //     }
-    // }
+int simulationRandom(Uint32 *state)
+{
+    // Linear congruential step, the top bits are the well mixed ones
+    *state = *state * 1664525u + 1013904223u;
+    return (int)(*state >> 16);
 }
 
-Vehicle *createVehicle(Direction direction)
+void initVehicle(Vehicle *vehicle, Direction direction, Uint32 *random)
 {
-    Vehicle *vehicle = (Vehicle *)malloc(sizeof(Vehicle));
+    // Fields a direction does not set start cleared, not with the slot's previous vehicle
+    memset(vehicle, 0, sizeof(*vehicle));
     vehicle->direction = direction;
 
-    // Set vehicle type with probabilities
-    int typeRoll = rand() % 100;
-    if (typeRoll < 5)
-    {
-        vehicle->type = AMBULANCE;
-    }
-    else if (typeRoll < 10)
-    {
-        vehicle->type = POLICE_CAR;
-    }
-    else if (typeRoll < 15)
+    // Set vehicle type with probabilities, the emergency share split evenly between the three types
+    int typeRoll = simulationRandom(random) % 100;
+    int emergencyPercent = simulationDemand.emergencyPercent;
+    if (typeRoll < emergencyPercent)
     {
-        vehicle->type = FIRE_TRUCK;
+        vehicle->type = (VehicleType)(AMBULANCE + typeRoll * 3 / emergencyPercent);
     }
     else
     {
@@ -221,7 +215,10 @@ Vehicle *createVehicle(Direction direction)
     }
 
     vehicle->active = true;
-    vehicle->canSkipLight = false; // Initialize canSkipLight to false
+    vehicle->lane = -1;
+    vehicle->queueLane = -1;
+    // Allow emergency vehicles to pass red lights
+    vehicle->canSkipLight = isEmergencyVehicle(vehicle);
     // Set speed based on vehicle type
     switch (vehicle->type)
     {
@@ -240,11 +237,11 @@ Vehicle *createVehicle(Direction direction)
     vehicle->turnAngle = 0.0f;
     vehicle->turnProgress = 0.0f;
 
-    // 30% chance to turn
-    int turnChance = rand() % 100;
-    if (turnChance < 30)
+    // Chance to turn, half of the turns to the left
+    int turnChance = simulationRandom(random) % 100;
+    if (turnChance < simulationDemand.turnPercent)
     {
-        vehicle->turnDirection = (turnChance < 15) ? TURN_LEFT : TURN_RIGHT;
+        vehicle->turnDirection = (turnChance < simulationDemand.turnPercent / 2) ? TURN_LEFT : TURN_RIGHT;
     }
     else
     {
@@ -323,10 +320,21 @@ Vehicle *createVehicle(Direction direction)
     vehicle->rect.x = (int)vehicle->x;
     vehicle->rect.y = (int)vehicle->y;
 
+    vehicle->prevX = vehicle->x;
+    vehicle->prevY = vehicle->y;
+    vehicle->prevTurnAngle = vehicle->turnAngle;
+}
+
+Vehicle *createVehicle(Direction direction)
+{
+    // Each vehicle draws from a stream seeded by rand(), so srand() still decides the sequence
+    Vehicle *vehicle = (Vehicle *)malloc(sizeof(Vehicle));
+    Uint32 random = (Uint32)rand();
+    initVehicle(vehicle, direction, &random);
     return vehicle;
 }
 
-void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
+void updateVehicle(Vehicle *vehicle, TrafficLight *lights, const LaneIndex *lanes)
 {
     if (!vehicle->active)
         return;
@@ -344,9 +352,9 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
     case DIRECTION_NORTH:
         stopLine = INTERSECTION_Y + LANE_WIDTH + 40;
         // Check for vehicles ahead in the same lane
-        for (int i = 0; i < vehiclesInLane[getVehicleLane(vehicle)]; i++)
+        for (int i = 0; i < lanes->counts[getVehicleLane(vehicle)]; i++)
         {
-            Vehicle *other = laneVehicles[getVehicleLane(vehicle)][i].vehicle;
+            Vehicle *other = lanes->vehicles[getVehicleLane(vehicle)][i].vehicle;
             if (other != vehicle && other->direction == vehicle->direction)
             {
                 float distance = vehicle->y - other->y;
@@ -371,9 +379,9 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
         break;
     case DIRECTION_SOUTH:
         stopLine = INTERSECTION_Y - LANE_WIDTH - 40;
-        for (int i = 0; i < vehiclesInLane[getVehicleLane(vehicle)]; i++)
+        for (int i = 0; i < lanes->counts[getVehicleLane(vehicle)]; i++)
         {
-            Vehicle *other = laneVehicles[getVehicleLane(vehicle)][i].vehicle;
+            Vehicle *other = lanes->vehicles[getVehicleLane(vehicle)][i].vehicle;
             if (other != vehicle && other->direction == vehicle->direction)
             {
                 float distance = other->y - vehicle->y;
@@ -397,9 +405,9 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
         break;
     case DIRECTION_EAST:
         stopLine = INTERSECTION_X - LANE_WIDTH - 40;
-        for (int i = 0; i < vehiclesInLane[getVehicleLane(vehicle)]; i++)
+        for (int i = 0; i < lanes->counts[getVehicleLane(vehicle)]; i++)
         {
-            Vehicle *other = laneVehicles[getVehicleLane(vehicle)][i].vehicle;
+            Vehicle *other = lanes->vehicles[getVehicleLane(vehicle)][i].vehicle;
             if (other != vehicle && other->direction == vehicle->direction)
             {
                 float distance = other->x - vehicle->x;
@@ -423,9 +431,9 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
         break;
     case DIRECTION_WEST:
         stopLine = INTERSECTION_X + LANE_WIDTH + 40;
-        for (int i = 0; i < vehiclesInLane[getVehicleLane(vehicle)]; i++)
+        for (int i = 0; i < lanes->counts[getVehicleLane(vehicle)]; i++)
         {
-            Vehicle *other = laneVehicles[getVehicleLane(vehicle)][i].vehicle;
+            Vehicle *other = lanes->vehicles[getVehicleLane(vehicle)][i].vehicle;
             if (other != vehicle && other->direction == vehicle->direction)
             {
                 float distance = vehicle->x - other->x;
@@ -480,7 +488,7 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
     if (shouldStop)
     {
         vehicle->state = STATE_STOPPING;
-        vehicle->speed *= 0.8f; // Increased deceleration
+        vehicle->speed *= powf(0.8f, simulationStepScale); // Increased deceleration
         if (vehicle->speed < 0.1f)
         {
             vehicle->state = STATE_STOPPED;
@@ -560,7 +568,7 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
     }
 
     // Movement logic
-    float moveSpeed = vehicle->speed;
+    float moveSpeed = vehicle->speed * simulationStepScale;
     if (vehicle->state == STATE_MOVING || vehicle->state == STATE_STOPPING)
     {
         switch (vehicle->direction)
@@ -582,7 +590,7 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
     else if (vehicle->state == STATE_TURNING)
     {
         // Calculate turn angle based on vehicle type
-        float turnSpeed = 1.0f;
+        float turnSpeed = 1.0f * simulationStepScale;
 
         vehicle->turnAngle += turnSpeed;
         vehicle->turnProgress = vehicle->turnAngle / 90.0f;
@@ -594,11 +602,13 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
             vehicle->isInRightLane = !vehicle->isInRightLane;
         }
 
-        // Calculate new position based on turn angle
-        float turnRadius = 0.5f;
+        // Calculate new position based on turn angle. Both parts of the offset
+        // are taken from where the vehicle is now, so like the angle step they
+        // are per tick and scale with it.
+        float turnRadius = 0.5f * simulationStepScale;
         float turnCenterX = 0;
         float turnCenterY = 0;
-        float turnCenter = 15;
+        float turnCenter = 15 * simulationStepScale;
         switch (vehicle->direction)
         {
         case DIRECTION_NORTH:
@@ -664,12 +674,38 @@ void updateVehicle(Vehicle *vehicle, TrafficLight *lights)
     }
 }
 
-void updateLanePositions(Vehicle *vehicles)
+void setSimulationTickRate(int ticksPerSecond)
+{
+    if (ticksPerSecond <= 0)
+        ticksPerSecond = SIM_TICK_RATE;
+    simulationTickRate = ticksPerSecond;
+    simulationStepScale = (float)SIM_TICK_RATE / ticksPerSecond;
+}
+
+Uint32 simulationTickAt(Uint32 milliseconds)
+{
+    // First tick whose simulation time reaches the given time
+    return (Uint32)(((Uint64)milliseconds * simulationTickRate + 999) / 1000);
+}
+
+void interpolateVehicle(const Vehicle *vehicle, float alpha, float *x, float *y, float *angle)
+{
+    *x = vehicle->prevX + (vehicle->x - vehicle->prevX) * alpha;
+    *y = vehicle->prevY + (vehicle->y - vehicle->prevY) * alpha;
+
+    // The angle snaps back to zero when a turn completes, don't sweep backwards through it
+    if (vehicle->turnAngle >= vehicle->prevTurnAngle)
+        *angle = vehicle->prevTurnAngle + (vehicle->turnAngle - vehicle->prevTurnAngle) * alpha;
+    else
+        *angle = vehicle->turnAngle;
+}
+
+void updateLanePositions(LaneIndex *lanes, Vehicle *vehicles)
 {
     // Reset lane tracking
     for (int i = 0; i < 4; i++)
     {
-        vehiclesInLane[i] = 0;
+        lanes->counts[i] = 0;
     }
 
     // Update lane positions for active vehicles
@@ -697,9 +733,9 @@ void updateLanePositions(Vehicle *vehicles)
                 break;
             }
 
-            laneVehicles[lane][vehiclesInLane[lane]].position = pos;
-            laneVehicles[lane][vehiclesInLane[lane]].vehicle = &vehicles[i];
-            vehiclesInLane[lane]++;
+            lanes->vehicles[lane][lanes->counts[lane]].position = pos;
+            lanes->vehicles[lane][lanes->counts[lane]].vehicle = &vehicles[i];
+            lanes->counts[lane]++;
         }
     }
 }
@@ -756,68 +792,623 @@ void renderRoads(SDL_Renderer *renderer)
     SDL_RenderFillRect(renderer, &westStop);
 }
 
-void renderQueues(SDL_Renderer *renderer)
+void resetCamera(Camera *camera)
+{
+    camera->x = 0.0f;
+    camera->y = 0.0f;
+    camera->zoom = 1.0f;
+}
+
+void panCamera(Camera *camera, float screenDx, float screenDy)
+{
+    camera->x += screenDx / camera->zoom;
+    camera->y += screenDy / camera->zoom;
+}
+
+void zoomCameraAt(Camera *camera, float factor, int screenX, int screenY)
+{
+    // Keep the world point under the cursor fixed while zooming
+    float worldX = camera->x + screenX / camera->zoom;
+    float worldY = camera->y + screenY / camera->zoom;
+
+    camera->zoom *= factor;
+    if (camera->zoom < CAMERA_MIN_ZOOM)
+        camera->zoom = CAMERA_MIN_ZOOM;
+    if (camera->zoom > CAMERA_MAX_ZOOM)
+        camera->zoom = CAMERA_MAX_ZOOM;
+
+    camera->x = worldX - screenX / camera->zoom;
+    camera->y = worldY - screenY / camera->zoom;
+}
+
+bool worldToScreenRect(const Camera *camera, float x, float y, float w, float h, int screenWidth, int screenHeight, SDL_FRect *out)
+{
+    out->x = (x - camera->x) * camera->zoom;
+    out->y = (y - camera->y) * camera->zoom;
+    out->w = w * camera->zoom;
+    out->h = h * camera->zoom;
+
+    // Report whether any part of the rectangle lands inside the viewport
+    return out->x + out->w >= 0 && out->y + out->h >= 0 && out->x < screenWidth && out->y < screenHeight;
+}
+
+// Static road geometry rasterised once into a texture and blitted every frame
+static SDL_Texture *roadLayer = NULL;
+static bool roadLayerIsTarget = false;
+static bool roadLayerDirty = true;
+
+static void rasteriseRoadLayer(SDL_Renderer *renderer)
+{
+    SDL_Texture *previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, roadLayer);
+    SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255); // Brighter background color
+    SDL_RenderClear(renderer);
+    renderRoads(renderer);
+    SDL_SetRenderTarget(renderer, previousTarget);
+    roadLayerDirty = false;
+}
+
+static SDL_Texture *rasteriseRoadLayerInSoftware(SDL_Renderer *renderer)
 {
+    // Render targets unavailable, draw the roads onto a surface and upload that once instead
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_RGBA8888);
+    if (surface == NULL)
+        return NULL;
+
+    SDL_Renderer *software = SDL_CreateSoftwareRenderer(surface);
+    if (software != NULL)
+    {
+        SDL_SetRenderDrawColor(software, 200, 200, 200, 255);
+        SDL_RenderClear(software);
+        renderRoads(software);
+        SDL_DestroyRenderer(software);
+    }
+
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+void renderRoadLayer(SDL_Renderer *renderer, const Camera *camera, int screenWidth, int screenHeight)
+{
+    if (roadLayer == NULL)
+    {
+        roadLayerIsTarget = SDL_RenderTargetSupported(renderer);
+        if (roadLayerIsTarget)
+            roadLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+        else
+            roadLayer = rasteriseRoadLayerInSoftware(renderer);
+        roadLayerDirty = roadLayerIsTarget;
+    }
+    if (roadLayerIsTarget && roadLayerDirty && roadLayer != NULL)
+    {
+        rasteriseRoadLayer(renderer);
+    }
+
+    // Background outside the world when zoomed out
+    SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
+    SDL_RenderClear(renderer);
+    if (roadLayer == NULL)
+        return;
+
+    // Only sample the part of the layer inside the viewport
+    float left = SDL_max(camera->x, 0.0f);
+    float top = SDL_max(camera->y, 0.0f);
+    float right = SDL_min(camera->x + screenWidth / camera->zoom, (float)WINDOW_WIDTH);
+    float bottom = SDL_min(camera->y + screenHeight / camera->zoom, (float)WINDOW_HEIGHT);
+    if (right <= left || bottom <= top)
+        return;
+
+    SDL_Rect source = {(int)left, (int)top, (int)SDL_ceilf(right) - (int)left, (int)SDL_ceilf(bottom) - (int)top};
+    SDL_FRect destination;
+    worldToScreenRect(camera, (float)source.x, (float)source.y, (float)source.w, (float)source.h, screenWidth, screenHeight, &destination);
+    SDL_RenderCopyF(renderer, roadLayer, &source, &destination);
+}
+
+void invalidateRoadLayer(bool textureLost)
+{
+    if (textureLost)
+    {
+        destroyRoadLayer();
+    }
+    roadLayerDirty = true;
+}
+
+void destroyRoadLayer(void)
+{
+    if (roadLayer != NULL)
+    {
+        SDL_DestroyTexture(roadLayer);
+        roadLayer = NULL;
+    }
+}
+
+void renderQueues(SDL_Renderer *renderer, const int *queueLengths)
+{
+    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue color for vehicles
     for (int i = 0; i < 4; i++)
     {
         int x = 10 + i * 200; // Adjust position for each lane
         int y = 10;
-        Node *current = laneQueues[i].front;
-        while (current != NULL)
+        for (int j = 0; j < queueLengths[i]; j++)
         {
             SDL_Rect vehicleRect = {x, y, 30, 30};
-            SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue color for vehicles
             SDL_RenderFillRect(renderer, &vehicleRect);
             y += 40; // Move down for the next vehicle
-            current = current->next;
         }
     }
 }
 
-void renderSimulation(SDL_Renderer *renderer, Vehicle *vehicles, TrafficLight *lights, Statistics *stats)
+// Vehicle sprites: one cell per vehicle type, drawn facing north (front at the top)
+static SDL_Texture *vehicleAtlas = NULL;
+static SDL_FPoint cornerOffsets[360][4];
+static SDL_Vertex vehicleVertices[MAX_VEHICLES * 4];
+static int vehicleIndices[MAX_VEHICLES * 6];
+
+static Uint32 packColor(Uint8 r, Uint8 g, Uint8 b)
 {
-    SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255); // Brighter background color
-    SDL_RenderClear(renderer);
+    return ((Uint32)r << 24) | ((Uint32)g << 16) | ((Uint32)b << 8) | 0xFF;
+}
 
-    // Render roads
-    renderRoads(renderer);
+static bool createVehicleSprites(SDL_Renderer *renderer)
+{
+    static Uint32 pixels[VEHICLE_SPRITE_HEIGHT][VEHICLE_SPRITE_WIDTH * VEHICLE_TYPE_COUNT];
+    const Uint32 glass = packColor(40, 40, 60);
+    const Uint32 outline = packColor(20, 20, 20);
+
+    for (int type = 0; type < VEHICLE_TYPE_COUNT; type++)
+    {
+        SDL_Color body = VEHICLE_COLORS[type];
+        for (int y = 0; y < VEHICLE_SPRITE_HEIGHT; y++)
+        {
+            for (int x = 0; x < VEHICLE_SPRITE_WIDTH; x++)
+            {
+                Uint32 color = packColor(body.r, body.g, body.b);
+                bool edge = x == 0 || y == 0 || x == VEHICLE_SPRITE_WIDTH - 1 || y == VEHICLE_SPRITE_HEIGHT - 1;
+                bool windshield = y >= 6 && y <= 10 && x >= 3 && x < VEHICLE_SPRITE_WIDTH - 3;
+                bool rearWindow = y >= 23 && y <= 25 && x >= 4 && x < VEHICLE_SPRITE_WIDTH - 4;
+                bool lightBar = type != REGULAR_CAR && y >= 13 && y <= 15 && x >= 3 && x < VEHICLE_SPRITE_WIDTH - 3;
+
+                if (edge)
+                    color = outline;
+                else if (windshield || rearWindow)
+                    color = glass;
+                else if (lightBar)
+                {
+                    // Red/blue for police, red/white for ambulances, yellow for fire trucks
+                    bool leftHalf = x < VEHICLE_SPRITE_WIDTH / 2;
+                    if (type == POLICE_CAR)
+                        color = leftHalf ? packColor(255, 0, 0) : packColor(0, 120, 255);
+                    else if (type == AMBULANCE)
+                        color = leftHalf ? packColor(255, 255, 255) : packColor(255, 0, 0);
+                    else
+                        color = packColor(255, 220, 0);
+                }
+                pixels[y][type * VEHICLE_SPRITE_WIDTH + x] = color;
+            }
+        }
+    }
+
+    vehicleAtlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC,
+                                     VEHICLE_SPRITE_WIDTH * VEHICLE_TYPE_COUNT, VEHICLE_SPRITE_HEIGHT);
+    if (vehicleAtlas == NULL)
+        return false;
+    SDL_UpdateTexture(vehicleAtlas, NULL, pixels, VEHICLE_SPRITE_WIDTH * VEHICLE_TYPE_COUNT * sizeof(Uint32));
+    SDL_SetTextureScaleMode(vehicleAtlas, SDL_ScaleModeLinear);
+
+    // Corner offsets from the vehicle centre for every whole-degree heading, clockwise from north
+    const float halfWidth = VEHICLE_SPRITE_WIDTH / 2.0f;
+    const float halfLength = VEHICLE_SPRITE_HEIGHT / 2.0f;
+    for (int degrees = 0; degrees < 360; degrees++)
+    {
+        float radians = degrees * (float)M_PI / 180.0f;
+        float forwardX = sinf(radians), forwardY = -cosf(radians);
+        float rightX = cosf(radians), rightY = sinf(radians);
+        cornerOffsets[degrees][0] = (SDL_FPoint){-rightX * halfWidth + forwardX * halfLength, -rightY * halfWidth + forwardY * halfLength};
+        cornerOffsets[degrees][1] = (SDL_FPoint){rightX * halfWidth + forwardX * halfLength, rightY * halfWidth + forwardY * halfLength};
+        cornerOffsets[degrees][2] = (SDL_FPoint){rightX * halfWidth - forwardX * halfLength, rightY * halfWidth - forwardY * halfLength};
+        cornerOffsets[degrees][3] = (SDL_FPoint){-rightX * halfWidth - forwardX * halfLength, -rightY * halfWidth - forwardY * halfLength};
+    }
+
+    // Two triangles per quad, the index pattern never changes
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        int *index = &vehicleIndices[i * 6];
+        index[0] = i * 4;
+        index[1] = i * 4 + 1;
+        index[2] = i * 4 + 2;
+        index[3] = i * 4;
+        index[4] = i * 4 + 2;
+        index[5] = i * 4 + 3;
+    }
+    return true;
+}
+
+void destroyVehicleSprites(void)
+{
+    if (vehicleAtlas != NULL)
+    {
+        SDL_DestroyTexture(vehicleAtlas);
+        vehicleAtlas = NULL;
+    }
+}
+
+int getVehicleHeading(const Vehicle *vehicle, float turnAngle)
+{
+    static const int baseHeading[4] = {0, 180, 90, 270}; // North, South, East, West
+    int heading = baseHeading[vehicle->direction];
+    if (vehicle->turnDirection == TURN_LEFT)
+        heading -= (int)(turnAngle + 0.5f);
+    else if (vehicle->turnDirection == TURN_RIGHT)
+        heading += (int)(turnAngle + 0.5f);
+    return ((heading % 360) + 360) % 360;
+}
+
+void renderVehicles(SDL_Renderer *renderer, const Vehicle *vehicles, float alpha, const Camera *camera, int screenWidth, int screenHeight)
+{
+    if (vehicleAtlas == NULL && !createVehicleSprites(renderer))
+        return;
+
+    const float atlasWidth = (float)(VEHICLE_SPRITE_WIDTH * VEHICLE_TYPE_COUNT);
+    const float cullRadius = VEHICLE_SPRITE_HEIGHT * camera->zoom;
+    int quadCount = 0;
+
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        if (!vehicles[i].active)
+            continue;
+
+        float x, y, angle;
+        interpolateVehicle(&vehicles[i], alpha, &x, &y, &angle);
+
+        // Rotate around the centre of the vehicle's footprint
+        float centreX = (x + vehicles[i].rect.w / 2.0f - camera->x) * camera->zoom;
+        float centreY = (y + vehicles[i].rect.h / 2.0f - camera->y) * camera->zoom;
+
+        // Skip vehicles outside the viewport
+        if (centreX < -cullRadius || centreY < -cullRadius || centreX > screenWidth + cullRadius || centreY > screenHeight + cullRadius)
+            continue;
+
+        const SDL_FPoint *offsets = cornerOffsets[getVehicleHeading(&vehicles[i], angle)];
+        float u0 = vehicles[i].type * VEHICLE_SPRITE_WIDTH / atlasWidth;
+        float u1 = (vehicles[i].type + 1) * VEHICLE_SPRITE_WIDTH / atlasWidth;
+        const SDL_FPoint texCoords[4] = {{u0, 0.0f}, {u1, 0.0f}, {u1, 1.0f}, {u0, 1.0f}};
+
+        SDL_Vertex *vertex = &vehicleVertices[quadCount * 4];
+        for (int corner = 0; corner < 4; corner++)
+        {
+            vertex[corner].position.x = centreX + offsets[corner].x * camera->zoom;
+            vertex[corner].position.y = centreY + offsets[corner].y * camera->zoom;
+            vertex[corner].color = (SDL_Color){255, 255, 255, 255};
+            vertex[corner].tex_coord = texCoords[corner];
+        }
+        quadCount++;
+    }
+
+    // Every vehicle in a single geometry call
+    if (quadCount > 0)
+    {
+        SDL_RenderGeometry(renderer, vehicleAtlas, vehicleVertices, quadCount * 4, vehicleIndices, quadCount * 6);
+    }
+}
+
+void destroyRenderCaches(void)
+{
+    destroyRoadLayer();
+    destroyVehicleSprites();
+    destroyHeatmap();
+}
+
+void renderSimulation(SDL_Renderer *renderer, const SimulationSnapshot *snapshot, const RenderView *view)
+{
+    const Camera *camera = &view->camera;
+    int screenWidth, screenHeight;
+    if (SDL_GetRendererOutputSize(renderer, &screenWidth, &screenHeight) != 0)
+    {
+        screenWidth = WINDOW_WIDTH;
+        screenHeight = WINDOW_HEIGHT;
+    }
+
+    // Render background and roads from the cached road layer
+    PROFILE_BEGIN(PROFILE_RENDER_ROADS);
+    renderRoadLayer(renderer, camera, screenWidth, screenHeight);
+    PROFILE_END(PROFILE_RENDER_ROADS);
 
     // Render traffic lights
     for (int i = 0; i < 4; i++)
     {
+        const TrafficLight *light = &snapshot->lights[i];
+        SDL_FRect position;
+        if (!worldToScreenRect(camera, (float)light->position.x, (float)light->position.y, (float)light->position.w, (float)light->position.h, screenWidth, screenHeight, &position))
+            continue;
         SDL_SetRenderDrawColor(renderer, 64, 64, 64, 255); // Dark gray for housing
-        SDL_RenderFillRect(renderer, &lights[i].position);
-        SDL_SetRenderDrawColor(renderer, (lights[i].state == RED) ? 255 : 0, (lights[i].state == GREEN) ? 255 : 0, 0, 255);
-        SDL_RenderFillRect(renderer, &lights[i].position);
+        SDL_RenderFillRectF(renderer, &position);
+        SDL_SetRenderDrawColor(renderer, (light->state == RED) ? 255 : 0, (light->state == GREEN) ? 255 : 0, 0, 255);
+        SDL_RenderFillRectF(renderer, &position);
+    }
+
+    // Interpolate between the previous and the published tick by how far we are into the next one
+    float alpha = 1.0f;
+    if (snapshot->tickDuration > 0)
+    {
+        alpha = (float)(SDL_GetPerformanceCounter() - snapshot->publishTime) / snapshot->tickDuration;
+        if (alpha > 1.0f)
+            alpha = 1.0f;
+    }
+
+    // Far too many vehicles to draw individually, show their density instead
+    bool useHeatmap = view->lodMode == LOD_HEATMAP ||
+                      (view->lodMode == LOD_AUTO && (snapshot->vehicleCount > LOD_VEHICLE_THRESHOLD || camera->zoom < LOD_ZOOM_THRESHOLD));
+    PROFILE_BEGIN(PROFILE_RENDER_VEHICLES);
+    if (useHeatmap)
+    {
+        SDL_FRect world;
+        worldToScreenRect(camera, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, screenWidth, screenHeight, &world);
+        renderHeatmap(renderer, snapshot->vehicles, &world);
+    }
+    else
+    {
+        // Render vehicles as rotated sprites in one batched draw call
+        renderVehicles(renderer, snapshot->vehicles, alpha, camera, screenWidth, screenHeight);
+    }
+    PROFILE_END(PROFILE_RENDER_VEHICLES);
+
+    // Render queues
+    renderQueues(renderer, snapshot->queueLengths);
+}
+
+void initSimulation(Simulation *sim)
+{
+    memset(sim, 0, sizeof(*sim));
+    initializeTrafficLights(sim->lights);
+    initSignalController(&sim->controller, simulationControllerType);
+    sim->stats.startTime = sim->time;
+
+    // The stream starts from the C generator, so srand() before this still
+    // decides the run while each simulation draws from its own
+    sim->random = (Uint32)rand();
+
+    // The node pool starts cleared with the rest, every queue takes from it
+    for (int i = 0; i < 4; i++)
+    {
+        initQueue(&sim->laneQueues[i], &sim->queueNodes);
     }
 
-    // Render vehicles
+    initTimingWheel(&sim->timers, sim->timerPool, SIMULATION_TIMERS, 0);
+    sim->spawnTimer = scheduleSimulationTimer(sim, simulationTickAt(simulationDemand.spawnInterval), TIMER_VEHICLE_SPAWN);
+    sim->signalTimer = -1;
+    sim->signalDecision = SIGNAL_WAIT_FOR_INPUT;
+    sim->signalDue = true;
+}
+
+void updateVehicleQueue(Simulation *sim, int index)
+{
+    Vehicle *vehicle = &sim->vehicles[index];
+    bool waiting = vehicle->active && vehicle->state == STATE_STOPPED;
+
+    if (waiting && vehicle->queueLane < 0)
+    {
+        // Joined the back of its lane's queue
+        QueueEntry entry = {index, sim->time};
+        vehicle->queueLane = getVehicleLane(vehicle);
+        enqueue(&sim->laneQueues[vehicle->queueLane], entry);
+        sim->signalInputChanged = true;
+    }
+    else if (!waiting && vehicle->queueLane >= 0)
+    {
+        // Discharged, record how long it waited
+        QueueEntry entry;
+        if (queueRemove(&sim->laneQueues[vehicle->queueLane], index, &entry))
+        {
+            sim->stats.totalWaitTime += sim->time - entry.enqueueTime;
+            sim->stats.vehiclesDischarged++;
+        }
+        vehicle->queueLane = -1;
+        sim->signalInputChanged = true;
+    }
+}
+
+static void spawnVehicle(Simulation *sim)
+{
+    Direction spawnDirection = (Direction)(simulationRandom(&sim->random) % 4);
+
+    // Built in the first empty slot, only called while one is free
     for (int i = 0; i < MAX_VEHICLES; i++)
     {
-        if (vehicles[i].active)
+        if (!sim->vehicles[i].active)
         {
-            SDL_SetRenderDrawColor(renderer, VEHICLE_COLORS[vehicles[i].type].r, VEHICLE_COLORS[vehicles[i].type].g, VEHICLE_COLORS[vehicles[i].type].b, VEHICLE_COLORS[vehicles[i].type].a);
-            SDL_RenderFillRect(renderer, &vehicles[i].rect);
+            initVehicle(&sim->vehicles[i], spawnDirection, &sim->random);
+            if (trackVehicleLane(sim, &sim->vehicles[i]))
+                sim->signalInputChanged = true;
+            sim->vehicleCount++;
+            sim->stats.totalVehicles++;
+            break;
         }
     }
 
-    // Render queues
-    renderQueues(renderer);
+    sim->lastVehicleSpawn = sim->time;
+    sim->spawnPending = false;
+    sim->spawnTimer = scheduleSimulationTimer(sim, simulationTickAt(sim->time + simulationDemand.spawnInterval), TIMER_VEHICLE_SPAWN);
+}
+
+void stepSimulation(Simulation *sim)
+{
+    Uint64 tickStart = SDL_GetPerformanceCounter();
+    PROFILE_BEGIN(PROFILE_TICK);
+
+    // Advance the simulation clock, spawns and light timers run on simulated time
+    sim->time = (Uint32)((Uint64)sim->tick * 1000 / simulationTickRate);
+
+    // Fire the timers due this tick
+    advanceTimingWheel(&sim->timers, sim->tick);
+    Timer fired;
+    while (popExpiredTimer(&sim->timers, &fired))
+    {
+        if (fired.type == TIMER_VEHICLE_SPAWN)
+        {
+            sim->spawnTimer = -1;
+            sim->spawnPending = true;
+        }
+        else if (fired.type == TIMER_SIGNAL_DECISION)
+        {
+            sim->signalTimer = -1;
+            sim->signalDue = true;
+        }
+    }
+
+    // A spawn that found every slot taken waits for the first free one
+    if (sim->spawnPending && sim->vehicleCount < MAX_VEHICLES)
+    {
+        spawnVehicle(sim);
+    }
+
+    // Hardware counter totals are also reported per vehicle updated
+    PERF_COUNT_VEHICLES(sim->vehicleCount);
+
+    PROFILE_BEGIN(PROFILE_LANE_POSITIONS);
+    updateLanePositions(&sim->lanes, sim->vehicles);
+    PROFILE_END(PROFILE_LANE_POSITIONS);
+
+    // Update vehicles
+    PROFILE_BEGIN(PROFILE_VEHICLE_UPDATE);
+    for (int i = 0; i < MAX_VEHICLES; i++)
+    {
+        if (sim->vehicles[i].active)
+        {
+            // Remember where the vehicle was so the renderer can interpolate
+            sim->vehicles[i].prevX = sim->vehicles[i].x;
+            sim->vehicles[i].prevY = sim->vehicles[i].y;
+            sim->vehicles[i].prevTurnAngle = sim->vehicles[i].turnAngle;
+
+            updateVehicle(&sim->vehicles[i], sim->lights, &sim->lanes);
+            updateVehicleQueue(sim, i);
+            if (trackVehicleLane(sim, &sim->vehicles[i]))
+                sim->signalInputChanged = true;
+
+            // Check if vehicle has passed through intersection
+            if (!sim->vehicles[i].active)
+            {
+                sim->stats.vehiclesPassed++;
+                sim->vehicleCount--;
+            }
+        }
+    }
+    PROFILE_END(PROFILE_VEHICLE_UPDATE);
+
+    if (sim->signalInputChanged && !sim->signalDue)
+        checkSignalInput(sim);
+    sim->signalInputChanged = false;
+
+    // Update traffic lights when a decision is due
+    if (sim->signalDue)
+    {
+        PROFILE_BEGIN(PROFILE_TRAFFIC_LIGHTS);
+        updateTrafficLights(sim);
+        PROFILE_END(PROFILE_TRAFFIC_LIGHTS);
+    }
 
-    SDL_RenderPresent(renderer);
+    // Update statistics
+    float minutes = (sim->time - sim->stats.startTime) / 60000.0f;
+    if (minutes > 0)
+    {
+        sim->stats.vehiclesPerMinute = sim->stats.vehiclesPassed / minutes;
+    }
+
+    sim->tick++;
+    sim->lastTickDuration = SDL_GetPerformanceCounter() - tickStart;
+    PROFILE_END(PROFILE_TICK);
+    ALLOC_COUNT_TICK();
+}
+
+// Steps the signal controller on every tick rather than only when its next
+// decision is due, so verifying it checks that the skipped steps change nothing
+static void stepSimulationPolledSignals(Simulation *sim)
+{
+    sim->signalDue = true;
+    stepSimulation(sim);
+}
+
+// Tick implementations, the first one is the reference the others are verified against
+static const SimulationEngine SIMULATION_ENGINES[] = {
+    {"reference", stepSimulation},
+    {"polled-signals", stepSimulationPolledSignals}};
+
+const SimulationEngine *findSimulationEngine(const char *name)
+{
+    for (size_t i = 0; i < sizeof(SIMULATION_ENGINES) / sizeof(SIMULATION_ENGINES[0]); i++)
+    {
+        if (strcmp(SIMULATION_ENGINES[i].name, name) == 0)
+            return &SIMULATION_ENGINES[i];
+    }
+    return NULL;
+}
+
+void captureSnapshot(const Simulation *sim, SimulationSnapshot *snapshot)
+{
+    memcpy(snapshot->vehicles, sim->vehicles, sizeof(snapshot->vehicles));
+    memcpy(snapshot->lights, sim->lights, sizeof(snapshot->lights));
+    snapshot->stats = sim->stats;
+    snapshot->vehicleCount = sim->vehicleCount;
+    for (int i = 0; i < 4; i++)
+    {
+        snapshot->queueLengths[i] = sim->laneQueues[i].size;
+        snapshot->queueWaitTimes[i] = queueWaitTime(&sim->laneQueues[i], sim->time);
+    }
+    snapshot->tick = sim->tick;
+    snapshot->simulationTime = sim->time;
+    snapshot->timeScale = 1;
+    snapshot->tickMilliseconds = (float)(sim->lastTickDuration * 1000.0 / SDL_GetPerformanceFrequency());
+    snapshot->publishTime = SDL_GetPerformanceCounter();
+    snapshot->tickDuration = SDL_GetPerformanceFrequency() / simulationTickRate;
+}
+
+// Nodes come from the queue's pool while it has any and from the heap after,
+// so a simulation's queues never allocate while other users may queue more
+static Node *allocateQueueNode(QueueNodePool *pool)
+{
+    if (pool != NULL && pool->free != NULL)
+    {
+        Node *node = pool->free;
+        pool->free = node->next;
+        return node;
+    }
+    if (pool != NULL && pool->used < QUEUE_NODE_POOL_SIZE)
+        return &pool->nodes[pool->used++];
+    return (Node *)malloc(sizeof(Node));
+}
+
+static void releaseQueueNode(QueueNodePool *pool, Node *node)
+{
+    if (pool == NULL || node < pool->nodes || node >= pool->nodes + QUEUE_NODE_POOL_SIZE)
+    {
+        free(node);
+        return;
+    }
+    node->next = pool->free;
+    pool->free = node;
 }
 
 // Queue functions
-void initQueue(Queue *q)
+void initQueue(Queue *q, QueueNodePool *pool)
 {
     q->front = q->rear = NULL;
     q->size = 0;
+    q->pool = pool;
 }
 
-void enqueue(Queue *q, Vehicle vehicle)
+void clearQueue(Queue *q)
 {
-    Node *newNode = (Node *)malloc(sizeof(Node));
-    newNode->vehicle = vehicle;
+    while (!isQueueEmpty(q))
+    {
+        dequeue(q);
+    }
+    initQueue(q, q->pool);
+}
+
+void enqueue(Queue *q, QueueEntry entry)
+{
+    Node *newNode = allocateQueueNode(q->pool);
+    newNode->entry = entry;
     newNode->next = NULL;
     if (q->rear == NULL)
     {
@@ -831,26 +1422,55 @@ void enqueue(Queue *q, Vehicle vehicle)
     q->size++;
 }
 
-Vehicle dequeue(Queue *q)
+QueueEntry dequeue(Queue *q)
 {
     if (q->front == NULL)
     {
-        Vehicle emptyVehicle = {0};
-        return emptyVehicle;
+        QueueEntry emptyEntry = {-1, 0};
+        return emptyEntry;
     }
     Node *temp = q->front;
-    Vehicle vehicle = temp->vehicle;
+    QueueEntry entry = temp->entry;
     q->front = q->front->next;
     if (q->front == NULL)
     {
         q->rear = NULL;
     }
-    free(temp);
+    releaseQueueNode(q->pool, temp);
     q->size--;
-    return vehicle;
+    return entry;
+}
+
+bool queueRemove(Queue *q, int vehicle, QueueEntry *removed)
+{
+    // Vehicles almost always discharge in order, so this normally stops at the front node
+    Node *previous = NULL;
+    for (Node *current = q->front; current != NULL; previous = current, current = current->next)
+    {
+        if (current->entry.vehicle != vehicle)
+            continue;
+
+        if (previous == NULL)
+            q->front = current->next;
+        else
+            previous->next = current->next;
+        if (q->rear == current)
+            q->rear = previous;
+
+        *removed = current->entry;
+        releaseQueueNode(q->pool, current);
+        q->size--;
+        return true;
+    }
+    return false;
+}
+
+Uint32 queueWaitTime(const Queue *q, Uint32 now)
+{
+    return q->front != NULL ? now - q->front->entry.enqueueTime : 0;
 }
 
 int isQueueEmpty(Queue *q)
 {
     return q->front == NULL;
-}
\ No newline at end of file
+}
@@ -3,11 +3,16 @@
 
 #include <SDL.h>
 #include <stdbool.h>
+#include "signal_controller.h"
+#include "timing_wheel.h"
+#include "profiler.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 #define LANE_WIDTH 80
+#ifndef MAX_VEHICLES
 #define MAX_VEHICLES 100
+#endif
 #define INTERSECTION_X (WINDOW_WIDTH / 2)
 #define INTERSECTION_Y (WINDOW_HEIGHT / 2)
 
@@ -15,6 +20,25 @@
 #define TRAFFIC_LIGHT_HEIGHT (LANE_WIDTH - LANE_WIDTH / 3)
 #define STOP_LINE_WIDTH 5
 
+#define VEHICLE_SPRITE_WIDTH 20   // Sprite footprint across and along the direction of travel
+#define VEHICLE_SPRITE_HEIGHT 30
+
+#define SIM_TICK_RATE 60      // Default simulation ticks per second, vehicle motion is tuned per tick at this rate
+#define SPAWN_INTERVAL 1000   // Default milliseconds between vehicle spawns
+#define EMERGENCY_PERCENT 15  // Default share of spawns that are emergency vehicles
+#define TURN_PERCENT 30       // Default share of spawns that turn, half left and half right
+#define SIMULATION_TIMERS 4   // Timer pool size: the spawn timer and the signal controller's wake-up
+#define QUEUE_NODE_POOL_SIZE MAX_VEHICLES  // Queue nodes, one per vehicle waiting at a light
+
+#define LOD_VEHICLE_THRESHOLD 2000  // Above this many vehicles the renderer switches to the density heatmap
+#define LOD_ZOOM_THRESHOLD 0.35f    // Zoomed out further than this the renderer switches to the density heatmap
+
+#define CAMERA_MIN_ZOOM 0.1f
+#define CAMERA_MAX_ZOOM 8.0f
+
+#define TIME_SCALE_PAUSED 0
+#define TIME_SCALE_UNLIMITED -1
+
 typedef enum {
     DIRECTION_NORTH,
     DIRECTION_SOUTH,
@@ -39,7 +63,8 @@ typedef enum {
     REGULAR_CAR,
     AMBULANCE,
     POLICE_CAR,
-    FIRE_TRUCK
+    FIRE_TRUCK,
+    VEHICLE_TYPE_COUNT
 } VehicleType;
 
 typedef enum {
@@ -47,6 +72,19 @@ typedef enum {
     GREEN
 } TrafficLightState;
 
+// Events scheduled on the simulation's timing wheel
+typedef enum {
+    TIMER_VEHICLE_SPAWN,
+    TIMER_SIGNAL_DECISION
+} TimerEvent;
+
+typedef enum {
+    LOD_AUTO,       // Individual vehicles, heatmap above LOD_VEHICLE_THRESHOLD
+    LOD_VEHICLES,
+    LOD_HEATMAP,
+    LOD_MODE_COUNT
+} LodMode;
+
 typedef struct {
     SDL_Rect rect;
     VehicleType type;
@@ -61,6 +99,11 @@ typedef struct {
     bool isInRightLane;
     bool turnProgress;
     bool canSkipLight; 
+    float prevX;          // Position and turn angle at the previous tick, for render interpolation
+    float prevY;
+    float prevTurnAngle;
+    int lane;             // Lane the vehicle is counted in, -1 when inactive
+    int queueLane;        // Lane queue the vehicle is waiting in, -1 when not queued
 } Vehicle;
 
 typedef struct {
@@ -75,18 +118,34 @@ typedef struct {
     int totalVehicles;
     float vehiclesPerMinute;
     Uint32 startTime;
+    Uint32 totalWaitTime;     // Simulated milliseconds spent queued by discharged vehicles
+    int vehiclesDischarged;
 } Statistics;
 
-// Queue data structure
+// Queue data structure, holding handles into the simulation's vehicle array
+typedef struct {
+    int vehicle;          // Index into Simulation.vehicles
+    Uint32 enqueueTime;   // Simulation time the vehicle stopped
+} QueueEntry;
+
 typedef struct Node {
-    Vehicle vehicle;
+    QueueEntry entry;
     struct Node* next;
 } Node;
 
+// Nodes for a set of queues. A vehicle waits in at most one queue, so
+// QUEUE_NODE_POOL_SIZE nodes cover a simulation and queuing never allocates.
+typedef struct {
+    Node nodes[QUEUE_NODE_POOL_SIZE];
+    int used;             // Nodes handed out at least once
+    Node* free;           // Returned nodes, linked through next
+} QueueNodePool;
+
 typedef struct {
     Node* front;
     Node* rear;
     int size;
+    QueueNodePool* pool;  // Where nodes come from, NULL or an exhausted pool falls back to the heap
 } Queue;
 
 typedef struct {
@@ -94,25 +153,130 @@ typedef struct {
     Vehicle* vehicle;
 } LanePosition;
 
-// Declare laneQueues as an external variable
-extern Queue laneQueues[4];
+// Active vehicles grouped by lane, rebuilt every tick for the following checks
+typedef struct {
+    LanePosition vehicles[4][MAX_VEHICLES];
+    int counts[4];
+} LaneIndex;
+
+// Traffic the spawner generates, set before a run starts
+typedef struct {
+    Uint32 spawnInterval;    // Milliseconds between vehicle spawns
+    int emergencyPercent;    // Split evenly between ambulances, police cars and fire trucks
+    int turnPercent;         // Split evenly between left and right turns
+} TrafficDemand;
+
+// Complete simulation state, owned by the simulation thread. Nothing a tick
+// reads or writes lives outside it, so several can be stepped side by side.
+typedef struct {
+    Vehicle vehicles[MAX_VEHICLES];
+    TrafficLight lights[4];
+    SignalController controller;
+    Statistics stats;
+    int vehicleCount;
+    Uint32 time;              // Simulated milliseconds since the start of the run
+    Uint32 random;            // Random stream for spawns, seeded from rand() by initSimulation()
+    Queue laneQueues[4];
+    QueueNodePool queueNodes;
+    int emergencyVehiclesInLane[4];
+    LaneIndex lanes;
+    Uint32 lastVehicleSpawn;
+    Timer timerPool[SIMULATION_TIMERS];
+    TimingWheel timers;
+    int spawnTimer;           // Pending TIMER_VEHICLE_SPAWN, -1 from when it fires until the spawn
+    int signalTimer;          // Pending TIMER_SIGNAL_DECISION, -1 when the controller waits for input
+    Uint32 signalDecision;    // Time of the controller's next timed decision, SIGNAL_WAIT_FOR_INPUT if none
+    bool signalDue;           // Step the controller this tick
+    bool signalInputChanged;  // A queue or emergency count changed this tick
+    bool spawnPending;        // A spawn fell due while every vehicle slot was taken
+    Uint32 tick;
+    Uint64 lastTickDuration;  // Performance counter ticks spent in the last stepSimulation()
+} Simulation;
+
+// One implementation of the tick. Every engine must leave exactly the state
+// the reference stepSimulation() does, verifySimulationEngine() checks it.
+typedef struct {
+    const char* name;
+    void (*step)(Simulation* sim);
+} SimulationEngine;
+
+// Immutable copy of the state the renderer needs, published once per tick
+typedef struct {
+    Vehicle vehicles[MAX_VEHICLES];
+    TrafficLight lights[4];
+    Statistics stats;
+    int vehicleCount;
+    int queueLengths[4];
+    Uint32 queueWaitTimes[4];  // How long the vehicle at the front of each queue has waited
+    Uint32 tick;
+    Uint32 simulationTime;
+    int timeScale;        // Ticks run per tick interval, TIME_SCALE_PAUSED or TIME_SCALE_UNLIMITED
+    float tickMilliseconds;
+    Uint64 publishTime;   // Performance counter when the tick was published
+    Uint64 tickDuration;  // Performance counter ticks between simulation ticks
+} SimulationSnapshot;
+
+typedef struct {
+    float x;     // World coordinate shown at the left edge of the screen
+    float y;     // World coordinate shown at the top edge of the screen
+    float zoom;  // Screen pixels per world unit
+} Camera;
+
+// Presentation settings owned by the render thread
+typedef struct {
+    LodMode lodMode;
+    Camera camera;
+} RenderView;
+
+// Run settings, fixed while simulations are stepping
+extern int simulationTickRate;
+extern float simulationStepScale;
+extern SignalControllerType simulationControllerType;
+extern TrafficDemand simulationDemand;
 
 // Function declarations
 void initializeTrafficLights(TrafficLight* lights);
-void updateTrafficLights(TrafficLight* lights);
+void applySignalPhase(TrafficLight* lights, int phase);
+int simulationRandom(Uint32* state);
+void initVehicle(Vehicle* vehicle, Direction direction, Uint32* random);
 Vehicle* createVehicle(Direction direction);
-void updateVehicle(Vehicle* vehicle, TrafficLight* lights);
-void renderSimulation(SDL_Renderer* renderer, Vehicle* vehicles, TrafficLight* lights, Statistics* stats);
+void updateVehicle(Vehicle* vehicle, TrafficLight* lights, const LaneIndex* lanes);
+void initSimulation(Simulation* sim);
+void updateTrafficLights(Simulation* sim);
+void stepSimulation(Simulation* sim);
+const SimulationEngine* findSimulationEngine(const char* name);
+void updateVehicleQueue(Simulation* sim, int index);
+void captureSnapshot(const Simulation* sim, SimulationSnapshot* snapshot);
+void renderSimulation(SDL_Renderer* renderer, const SimulationSnapshot* snapshot, const RenderView* view);
 void renderRoads(SDL_Renderer* renderer);
-void renderQueues(SDL_Renderer* renderer);
+void renderRoadLayer(SDL_Renderer* renderer, const Camera* camera, int screenWidth, int screenHeight);
+void invalidateRoadLayer(bool textureLost);
+void destroyRoadLayer(void);
+void renderVehicles(SDL_Renderer* renderer, const Vehicle* vehicles, float alpha, const Camera* camera, int screenWidth, int screenHeight);
+int getVehicleHeading(const Vehicle* vehicle, float turnAngle);
+void destroyVehicleSprites(void);
+void destroyRenderCaches(void);
+void resetCamera(Camera* camera);
+void panCamera(Camera* camera, float screenDx, float screenDy);
+void zoomCameraAt(Camera* camera, float factor, int screenX, int screenY);
+bool worldToScreenRect(const Camera* camera, float x, float y, float w, float h, int screenWidth, int screenHeight, SDL_FRect* out);
+void renderQueues(SDL_Renderer* renderer, const int* queueLengths);
 float getDistanceBetweenVehicles(Vehicle* v1, Vehicle* v2);
 int getVehicleLane(Vehicle* vehicle);
-void updateLanePositions(Vehicle* vehicles);
+bool isEmergencyVehicle(const Vehicle* vehicle);
+bool trackVehicleLane(Simulation* sim, Vehicle* vehicle);
+void updateLanePositions(LaneIndex* lanes, Vehicle* vehicles);
+void setSimulationTickRate(int ticksPerSecond);
+Uint32 simulationTickAt(Uint32 milliseconds);
+void interpolateVehicle(const Vehicle* vehicle, float alpha, float* x, float* y, float* angle);
 
 // Queue functions
-void initQueue(Queue* q);
-void enqueue(Queue* q, Vehicle vehicle);
-Vehicle dequeue(Queue* q);
+void initQueue(Queue* q, QueueNodePool* pool);
+void clearQueue(Queue* q);
+void enqueue(Queue* q, QueueEntry entry);
+QueueEntry dequeue(Queue* q);
+bool queueRemove(Queue* q, int vehicle, QueueEntry* removed);
+Uint32 queueWaitTime(const Queue* q, Uint32 now);
 int isQueueEmpty(Queue* q);
 
 #endif
\ No newline at end of file